@@ -0,0 +1,436 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Asynchronous file writer for large outputs (such as digit files and checkpoints), so the
+   calculation can continue while the data is written to disk instead of waiting for it.
+
+   Data is copied into a small ring of page-aligned buffers, each of which is written at its own
+   file offset once full. Large blocks of data that stay unchanged until the file is closed can
+   instead be written directly from the caller's memory without being copied.
+
+   On Linux this uses io_uring, where the kernel performs the writes and a single thread waits for
+   them to complete. If io_uring is unavailable (older kernels, other OSs or blocked by a sandbox),
+   each buffer is written by its own thread instead.
+
+   The writer records how long the writes took and how long the caller spent waiting for them,
+   so the time hidden behind the calculation can be reported.
+
+   See https://kernel.dk/io_uring.pdf for more information.
+*/
+
+#ifndef PI_C_ASYNCIO_H
+#define PI_C_ASYNCIO_H
+
+/* Needed for pwrite, posix_memalign and the io_uring system calls when compiling as strict C99. */
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
+/* Required includes. */
+#include "c_threads.h"
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <fcntl.h>
+#ifdef _MSC_VER
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#endif
+
+/* io_uring needs the system call numbers, which older headers may not have. */
+#if defined(__linux__) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define PIDEF_HAVE_URING
+#endif
+
+/* Size and number of the buffers being filled or written. Buffers are aligned to this many bytes. */
+#define PIDEF_WRITE_BUFFER_SIZE ((size_t)4 << 20)
+#define PIDEF_WRITE_BUFFERS 8
+#define PIDEF_WRITE_ALIGN 4096
+
+/* Largest single write made directly from the caller's memory. */
+#define PIDEF_WRITE_REF_CHUNK ((size_t)1 << 30)
+
+/* A buffer and the write it is part of. */
+typedef struct pidef_writer pidef_writer;
+typedef struct {
+	pidef_writer *writer;
+	unsigned char *data; /* Data to write, either 'own' or the caller's memory. */
+	unsigned char *own; /* The buffer's own memory. */
+	size_t size; /* Bytes to write. */
+	uint64_t offset; /* File offset to write to. */
+	double submit_time, end_time; /* Wall times the write was queued at and finished at. */
+	int queued; /* Non-zero from when the buffer is written until its write has been waited for. */
+	int busy; /* Non-zero while the buffer is being written. Cleared by the io_uring completion thread. */
+	int failed; /* Non-zero if the write did not complete. */
+	thread_id_t thread; /* Thread writing the buffer, when io_uring is not used. */
+} pidef_write_buffer;
+
+struct pidef_writer {
+	int fd;
+	uint64_t offset; /* File offset of the next queued buffer. */
+	pidef_write_buffer buffers[PIDEF_WRITE_BUFFERS];
+	int current; /* Index of the buffer being filled. */
+	int failed; /* Non-zero if any write failed. */
+	int uses_uring; /* Non-zero if the writes use io_uring. */
+
+	/* Statistics. */
+	uint64_t bytes;
+	double write_seconds; /* Total time the writes were in progress. */
+	double wait_seconds; /* Time the caller spent waiting for writes to complete. */
+
+	#ifdef PIDEF_HAVE_URING
+	int ring_fd; /* io_uring instance, or -1 if writing with threads. */
+	thread_id_t reaper; /* Thread handling completed writes. */
+	void *sq_ring, *cq_ring;
+	size_t sq_ring_size, cq_ring_size;
+	unsigned sq_entries;
+	struct io_uring_sqe *sqes;
+	unsigned *sq_tail, *sq_mask, *sq_array, *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_cqe *cqes;
+	#endif
+};
+
+
+/*
+   Function declarations.
+*/
+
+/* Creates (or truncates) the given file for writing. Returns non-zero on success. */
+int pidef_writer_open(pidef_writer *writer, const char *path);
+
+/* Queues the given data to be written after any previous data, waiting only if all buffers are in use. */
+void pidef_writer_write(pidef_writer *writer, const void *data, size_t size);
+
+/*
+   Queues the given data to be written after any previous data without copying it, so it must
+   not be changed or freed until the writer is closed.
+*/
+void pidef_writer_write_ref(pidef_writer *writer, const void *data, size_t size);
+
+/* Writes any remaining data, waits for all writes and closes the file. Returns non-zero if everything was written. */
+int pidef_writer_close(pidef_writer *writer);
+
+/* Returns the name of the method used for writing. */
+const char *pidef_writer_backend(const pidef_writer *writer);
+
+/* Prints the amount of data written and how much of the write time was hidden behind other work. */
+void pidef_writer_print_stats(const pidef_writer *writer, const char *name);
+
+
+/*
+   Function definitions.
+*/
+
+/* Writes all of the given data at the given offset, returning non-zero on success. */
+static int pidef_pwrite_all(int fd, const unsigned char *data, size_t size, uint64_t offset) {
+	while (size) {
+		#ifdef _MSC_VER
+		/* Windows has no pwrite, so write through an overlapped structure holding the offset. */
+		OVERLAPPED overlapped;
+		DWORD written = 0;
+		memset(&overlapped, 0, sizeof overlapped);
+		overlapped.Offset = (DWORD)offset;
+		overlapped.OffsetHigh = (DWORD)(offset >> 32);
+		const DWORD chunk = size > 0x40000000u ? 0x40000000u : (DWORD)size;
+		if (!WriteFile((HANDLE)_get_osfhandle(fd), data, chunk, &written, &overlapped) || !written) return 0;
+		#else
+		const ssize_t written = pwrite(fd, data, size, (off_t)offset);
+		if (written <= 0) return 0;
+		#endif
+
+		data += written;
+		size -= (size_t)written;
+		offset += (uint64_t)written;
+	}
+	return 1;
+}
+
+/* Threading wrapper for writing a single buffer. */
+static thread_func_t pidef_write_buffer_thread(thread_arg_t data) {
+	pidef_write_buffer *const buffer = (pidef_write_buffer*)data;
+	buffer->failed = !pidef_pwrite_all(buffer->writer->fd, buffer->data, buffer->size, buffer->offset);
+	buffer->end_time = pidef_wall_seconds();
+	return 0;
+}
+
+#ifdef PIDEF_HAVE_URING
+/* Sets up an io_uring instance for the writer. Returns non-zero on success. */
+static int pidef_uring_setup(pidef_writer *writer) {
+	struct io_uring_params params;
+	memset(&params, 0, sizeof params);
+	writer->ring_fd = (int)syscall(__NR_io_uring_setup, PIDEF_WRITE_BUFFERS, &params);
+	if (writer->ring_fd < 0) {
+		writer->ring_fd = -1;
+		return 0;
+	}
+
+	/* Map the submission and completion rings (a single mapping on newer kernels) and the submission entries. */
+	writer->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	writer->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (writer->cq_ring_size > writer->sq_ring_size) writer->sq_ring_size = writer->cq_ring_size;
+		writer->cq_ring_size = writer->sq_ring_size;
+	}
+
+	writer->sq_ring = mmap(NULL, writer->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, writer->ring_fd, IORING_OFF_SQ_RING);
+	writer->cq_ring = params.features & IORING_FEAT_SINGLE_MMAP ? writer->sq_ring :
+		mmap(NULL, writer->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, writer->ring_fd, IORING_OFF_CQ_RING);
+	writer->sq_entries = params.sq_entries;
+	void *const sqes = mmap(NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, writer->ring_fd, IORING_OFF_SQES);
+
+	if (writer->sq_ring == MAP_FAILED || writer->cq_ring == MAP_FAILED || sqes == MAP_FAILED) {
+		if (writer->sq_ring != MAP_FAILED) munmap(writer->sq_ring, writer->sq_ring_size);
+		if (writer->cq_ring != MAP_FAILED && writer->cq_ring != writer->sq_ring) munmap(writer->cq_ring, writer->cq_ring_size);
+		if (sqes != MAP_FAILED) munmap(sqes, params.sq_entries * sizeof(struct io_uring_sqe));
+		close(writer->ring_fd);
+		writer->ring_fd = -1;
+		return 0;
+	}
+
+	unsigned char *const sq = (unsigned char*)writer->sq_ring, *const cq = (unsigned char*)writer->cq_ring;
+	writer->sqes = (struct io_uring_sqe*)sqes;
+	writer->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+	writer->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+	writer->sq_array = (unsigned*)(sq + params.sq_off.array);
+	writer->cq_head = (unsigned*)(cq + params.cq_off.head);
+	writer->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+	writer->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+	writer->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+	return 1;
+}
+
+/* Frees the writer's io_uring instance. */
+static void pidef_uring_free(pidef_writer *writer) {
+	munmap(writer->sqes, writer->sq_entries * sizeof(struct io_uring_sqe));
+	if (writer->cq_ring != writer->sq_ring) munmap(writer->cq_ring, writer->cq_ring_size);
+	munmap(writer->sq_ring, writer->sq_ring_size);
+	close(writer->ring_fd);
+	writer->ring_fd = -1;
+}
+
+/* Queues a single submission, returning non-zero if it was submitted. */
+static int pidef_uring_submit(pidef_writer *writer, uint8_t opcode, const pidef_write_buffer *buffer, uint64_t user_data) {
+	const unsigned tail = *writer->sq_tail, index = tail & *writer->sq_mask;
+	struct io_uring_sqe *const sqe = &writer->sqes[index];
+	memset(sqe, 0, sizeof *sqe);
+	sqe->opcode = opcode;
+	sqe->fd = writer->fd;
+	if (buffer) {
+		sqe->addr = (uint64_t)(uintptr_t)buffer->data;
+		sqe->len = (uint32_t)buffer->size;
+		sqe->off = buffer->offset;
+	}
+	sqe->user_data = user_data;
+	writer->sq_array[index] = index;
+	__atomic_store_n(writer->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	if (syscall(__NR_io_uring_enter, writer->ring_fd, 1, 0, 0, NULL, 0) == 1) return 1;
+	__atomic_store_n(writer->sq_tail, tail, __ATOMIC_RELEASE);
+	return 0;
+}
+
+/*
+   Handles completed writes as soon as they finish, so their times are exact, until the
+   submission with a user data of UINT64_MAX completes. Runs in its own thread.
+*/
+static thread_func_t pidef_uring_reaper(thread_arg_t data) {
+	pidef_writer *const writer = (pidef_writer*)data;
+
+	for (;;) {
+		syscall(__NR_io_uring_enter, writer->ring_fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+
+		unsigned head = *writer->cq_head;
+		const unsigned tail = __atomic_load_n(writer->cq_tail, __ATOMIC_ACQUIRE);
+		for (; head != tail; ++head) {
+			const struct io_uring_cqe *const cqe = &writer->cqes[head & *writer->cq_mask];
+			if (cqe->user_data == UINT64_MAX) {
+				__atomic_store_n(writer->cq_head, head + 1, __ATOMIC_RELEASE);
+				return 0;
+			}
+
+			/* Finish short or failed writes (such as on kernels without IORING_OP_WRITE) synchronously. */
+			pidef_write_buffer *const buffer = &writer->buffers[cqe->user_data];
+			const size_t written = cqe->res > 0 ? (size_t)cqe->res : 0;
+			if (written < buffer->size) {
+				buffer->failed = !pidef_pwrite_all(writer->fd, buffer->data + written, buffer->size - written, buffer->offset + written);
+			}
+			buffer->end_time = pidef_wall_seconds();
+			__atomic_store_n(&buffer->busy, 0, __ATOMIC_RELEASE);
+		}
+		__atomic_store_n(writer->cq_head, head, __ATOMIC_RELEASE);
+	}
+}
+#endif
+
+/* Waits for the given buffer's write to complete, if it is being written. */
+static void pidef_writer_wait(pidef_writer *writer, pidef_write_buffer *buffer) {
+	if (!buffer->queued) return;
+	const double start = pidef_wall_seconds();
+
+	#ifdef PIDEF_HAVE_URING
+	if (writer->uses_uring) {
+		/* The completion thread marks the buffer as finished. */
+		const struct timespec pause = { 0, 100000 };
+		while (__atomic_load_n(&buffer->busy, __ATOMIC_ACQUIRE)) nanosleep(&pause, NULL);
+	} else
+	#endif
+	pidef_join_thread(buffer->thread);
+
+	writer->wait_seconds += pidef_wall_seconds() - start;
+	writer->write_seconds += buffer->end_time - buffer->submit_time;
+	writer->failed |= buffer->failed;
+	buffer->queued = 0;
+}
+
+/* Starts writing the buffer currently being filled and moves on to the next one, waiting for it if it is still being written. */
+static void pidef_writer_submit(pidef_writer *writer) {
+	pidef_write_buffer *const buffer = &writer->buffers[writer->current];
+	if (!buffer->size) return;
+
+	buffer->offset = writer->offset;
+	buffer->submit_time = pidef_wall_seconds();
+	buffer->queued = 1;
+	buffer->busy = 1;
+	buffer->failed = 0;
+	writer->offset += buffer->size;
+	writer->bytes += buffer->size;
+
+	#ifdef PIDEF_HAVE_URING
+	if (writer->uses_uring) {
+		if (!pidef_uring_submit(writer, IORING_OP_WRITE, buffer, (uint64_t)writer->current)) {
+			/* Could not submit, so write it now instead. */
+			buffer->failed = !pidef_pwrite_all(writer->fd, buffer->data, buffer->size, buffer->offset);
+			buffer->end_time = pidef_wall_seconds();
+			buffer->busy = 0;
+		}
+	} else
+	#endif
+	pidef_create_thread(&buffer->thread, pidef_write_buffer_thread, buffer);
+
+	writer->current = (writer->current + 1) % PIDEF_WRITE_BUFFERS;
+	pidef_writer_wait(writer, &writer->buffers[writer->current]);
+	writer->buffers[writer->current].data = writer->buffers[writer->current].own;
+	writer->buffers[writer->current].size = 0;
+}
+
+int pidef_writer_open(pidef_writer *writer, const char *path) {
+	memset(writer, 0, sizeof *writer);
+
+	#ifdef _MSC_VER
+	writer->fd = _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+	#else
+	writer->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	#endif
+	if (writer->fd < 0) return 0;
+
+	for (int i = 0; i < PIDEF_WRITE_BUFFERS; ++i) {
+		pidef_write_buffer *const buffer = &writer->buffers[i];
+		buffer->writer = writer;
+		#ifdef _MSC_VER
+		buffer->own = (unsigned char*)_aligned_malloc(PIDEF_WRITE_BUFFER_SIZE, PIDEF_WRITE_ALIGN);
+		#else
+		void *data = NULL;
+		if (posix_memalign(&data, PIDEF_WRITE_ALIGN, PIDEF_WRITE_BUFFER_SIZE)) data = NULL;
+		buffer->own = (unsigned char*)data;
+		#endif
+		buffer->data = buffer->own;
+
+		if (!buffer->data) {
+			fprintf(stderr, "Could not allocate memory for write buffers.\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	#ifdef PIDEF_HAVE_URING
+	writer->uses_uring = pidef_uring_setup(writer);
+	if (writer->uses_uring) pidef_create_thread(&writer->reaper, pidef_uring_reaper, writer);
+	#endif
+	return 1;
+}
+
+void pidef_writer_write(pidef_writer *writer, const void *data, size_t size) {
+	const unsigned char *bytes = (const unsigned char*)data;
+
+	while (size) {
+		pidef_write_buffer *const buffer = &writer->buffers[writer->current];
+
+		/* Fill the current buffer, starting its write once it is full. */
+		const size_t space = PIDEF_WRITE_BUFFER_SIZE - buffer->size, count = size < space ? size : space;
+		memcpy(buffer->data + buffer->size, bytes, count);
+		buffer->size += count;
+		bytes += count;
+		size -= count;
+
+		if (buffer->size == PIDEF_WRITE_BUFFER_SIZE) pidef_writer_submit(writer);
+	}
+}
+
+void pidef_writer_write_ref(pidef_writer *writer, const void *data, size_t size) {
+	const unsigned char *bytes = (const unsigned char*)data;
+
+	/* Anything already buffered is written first, then each chunk is written from its own buffer slot. */
+	pidef_writer_submit(writer);
+	while (size) {
+		pidef_write_buffer *const buffer = &writer->buffers[writer->current];
+		const size_t count = size < PIDEF_WRITE_REF_CHUNK ? size : PIDEF_WRITE_REF_CHUNK;
+		buffer->data = (unsigned char*)(uintptr_t)bytes;
+		buffer->size = count;
+		pidef_writer_submit(writer);
+		bytes += count;
+		size -= count;
+	}
+}
+
+int pidef_writer_close(pidef_writer *writer) {
+	pidef_writer_submit(writer);
+	for (int i = 0; i < PIDEF_WRITE_BUFFERS; ++i) pidef_writer_wait(writer, &writer->buffers[i]);
+
+	#ifdef PIDEF_HAVE_URING
+	if (writer->uses_uring) {
+		/* Stop the completion thread with a no-op. */
+		if (!pidef_uring_submit(writer, IORING_OP_NOP, NULL, UINT64_MAX)) {
+			fprintf(stderr, "Could not stop the io_uring completion thread.\n");
+			exit(EXIT_FAILURE);
+		}
+		pidef_join_thread(writer->reaper);
+		pidef_uring_free(writer);
+	}
+	#endif
+
+	for (int i = 0; i < PIDEF_WRITE_BUFFERS; ++i) {
+		#ifdef _MSC_VER
+		_aligned_free(writer->buffers[i].own);
+		#else
+		free(writer->buffers[i].own);
+		#endif
+	}
+
+	#ifdef _MSC_VER
+	writer->failed |= _close(writer->fd) != 0;
+	#else
+	writer->failed |= close(writer->fd) != 0;
+	#endif
+	return !writer->failed;
+}
+
+const char *pidef_writer_backend(const pidef_writer *writer) {
+	return writer->uses_uring ? "io_uring" : "threads";
+}
+
+void pidef_writer_print_stats(const pidef_writer *writer, const char *name) {
+	const double hidden = writer->write_seconds > writer->wait_seconds ? writer->write_seconds - writer->wait_seconds : 0.0;
+	printf("%s: %.1f MiB written with %s, %fs of writes (%fs waited, %fs hidden)\n", name, (double)writer->bytes / 1048576.0,
+		pidef_writer_backend(writer), writer->write_seconds, writer->wait_seconds, hidden);
+}
+
+#endif
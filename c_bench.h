@@ -0,0 +1,235 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Benchmarking helpers shared by the pi programs, measuring more than the time taken around
+   a region of code.
+
+   Hardware event counters (such as data TLB misses) are read with the Linux perf_event_open
+   interface. They are reported as unavailable on other OSs, or when the kernel does not allow
+   them (see /proc/sys/kernel/perf_event_paranoid).
+
+   Cycle counts are read from the x86 timestamp counter (TSC), calibrated against the wall clock. The TSC ticks
+   at a constant reference rate on current processors, so its cycles differ from core cycles under turbo or power
+   saving. Other processors count nanoseconds instead.
+
+   Energy is read from the RAPL (running average power limit) counters of each processor package that Linux
+   exposes in /sys/class/powercap, on both Intel and AMD processors. Only the top level zones named
+   "package-N" are summed, as others such as "psys" (the whole platform) already include the packages.
+   The counters wrap around at the range given next to them, which is handled as long as a region takes
+   less than one wrap (usually minutes at full power). Newer kernels only let root read them; the energy
+   is reported as unavailable otherwise.
+*/
+
+#ifndef PI_C_BENCH_H
+#define PI_C_BENCH_H
+
+/* Needed for syscall() when compiling as strict C99. */
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
+/* Required includes. */
+#include "c_threads.h"
+#include <inttypes.h>
+#include <string.h>
+#include <stdio.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PIDEF_HAVE_TSC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define PIDEF_HAVE_TSC
+#endif
+
+/* Seconds of the wall clock that the timestamp counter is calibrated against. */
+#define PIDEF_TSC_CALIBRATION 0.05
+
+/* Directory of the power capping zones, and the most package zones that are read. */
+#ifndef PIDEF_POWERCAP_PATH
+#define PIDEF_POWERCAP_PATH "/sys/class/powercap"
+#endif
+#define PIDEF_ENERGY_MAX_ZONES 16
+
+/* A hardware event counter for the calling process, including threads created after it is started. */
+typedef struct {
+	int fd; /* Counter file descriptor, or -1 if unavailable. */
+	uint64_t value; /* Number of events counted once stopped. */
+} pidef_counter;
+
+/* Energy used by all processor packages over a region, from the RAPL counters. */
+typedef struct {
+	int zones; /* Number of package zones read, or 0 if unavailable. */
+	int zone[PIDEF_ENERGY_MAX_ZONES]; /* Numbers of the package zones in the powercap directory. */
+	uint64_t start[PIDEF_ENERGY_MAX_ZONES], range[PIDEF_ENERGY_MAX_ZONES]; /* Microjoules. */
+	double start_time, seconds, joules;
+} pidef_energy;
+
+/* Starts counting data TLB read misses. Returns non-zero if the counter is available. */
+int pidef_counter_start_dtlb(pidef_counter *counter);
+
+/* Stops the given counter and stores the number of events. */
+void pidef_counter_stop(pidef_counter *counter);
+
+/* Prints the given counter's value with a name, or that it is unavailable. */
+void pidef_counter_print(const pidef_counter *counter, const char *name);
+
+/* Returns the timestamp counter, or nanoseconds of the wall clock where there is none. */
+uint64_t pidef_tsc(void);
+
+/* Returns the ticks per second of pidef_tsc, calibrated on the first call. */
+double pidef_tsc_hz(void);
+
+/* Starts measuring energy. Returns non-zero if the counters are available. */
+int pidef_energy_start(pidef_energy *energy);
+
+/* Stops measuring energy, storing the joules used and the wall time taken. */
+void pidef_energy_stop(pidef_energy *energy);
+
+/*
+   Prints the energy used, the average power and the work done per joule, such as 'work' digits
+   for a 'unit' of "digits", or that the energy is unavailable.
+*/
+void pidef_energy_print(const pidef_energy *energy, double work, const char *unit);
+
+int pidef_counter_start_dtlb(pidef_counter *counter) {
+	counter->fd = -1;
+	counter->value = 0;
+
+	#ifdef __linux__
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof attr);
+	attr.size = sizeof attr;
+	attr.type = PERF_TYPE_HW_CACHE;
+	attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	attr.disabled = 1;
+	attr.inherit = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	counter->fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	if (counter->fd < 0) {
+		counter->fd = -1;
+		return 0;
+	}
+	ioctl(counter->fd, PERF_EVENT_IOC_RESET, 0);
+	ioctl(counter->fd, PERF_EVENT_IOC_ENABLE, 0);
+	#endif
+
+	return counter->fd >= 0;
+}
+
+void pidef_counter_stop(pidef_counter *counter) {
+	if (counter->fd < 0) return;
+
+	#ifdef __linux__
+	ioctl(counter->fd, PERF_EVENT_IOC_DISABLE, 0);
+	if (read(counter->fd, &counter->value, sizeof counter->value) != (ssize_t)sizeof counter->value) counter->value = 0;
+	close(counter->fd);
+	#endif
+}
+
+void pidef_counter_print(const pidef_counter *counter, const char *name) {
+	if (counter->fd < 0) printf("%s: unavailable\n", name);
+	else printf("%s: %" PRIu64 "\n", name, counter->value);
+}
+
+uint64_t pidef_tsc(void) {
+	#ifdef PIDEF_HAVE_TSC
+	return (uint64_t)__rdtsc();
+	#else
+	return (uint64_t)(pidef_wall_seconds() * 1e9);
+	#endif
+}
+
+double pidef_tsc_hz(void) {
+	static double hz;
+	if (hz > 0.0) return hz;
+
+	const double start_time = pidef_wall_seconds();
+	const uint64_t start = pidef_tsc();
+	double seconds;
+	while ((seconds = pidef_wall_seconds() - start_time) < PIDEF_TSC_CALIBRATION);
+	hz = (double)(pidef_tsc() - start) / seconds;
+	return hz;
+}
+
+/* Reads the name of the given zone, returning non-zero on success. */
+static int pidef_energy_name(int zone, char *name, int size) {
+	char path[256];
+	snprintf(path, sizeof path, "%s/intel-rapl:%d/name", PIDEF_POWERCAP_PATH, zone);
+	FILE *const file = fopen(path, "r");
+	if (!file) return 0;
+	const int valid = fgets(name, size, file) != NULL;
+	fclose(file);
+	return valid;
+}
+
+/* Reads a counter file of the given zone, returning non-zero on success. */
+static int pidef_energy_read(int zone, const char *name, uint64_t *value) {
+	char path[256];
+	snprintf(path, sizeof path, "%s/intel-rapl:%d/%s", PIDEF_POWERCAP_PATH, zone, name);
+	FILE *const file = fopen(path, "r");
+	if (!file) return 0;
+	const int valid = fscanf(file, "%" SCNu64, value) == 1;
+	fclose(file);
+	return valid;
+}
+
+int pidef_energy_start(pidef_energy *energy) {
+	energy->zones = 0;
+	energy->seconds = energy->joules = 0.0;
+
+	/*
+	   Only the top level package zones are read, as the zones below them are parts of the package and
+	   other top level zones (such as psys) would count the packages twice.
+	*/
+	#ifdef __linux__
+	char name[64];
+	for (int zone = 0; energy->zones < PIDEF_ENERGY_MAX_ZONES && pidef_energy_name(zone, name, (int)sizeof name); ++zone) {
+		const int i = energy->zones;
+		if (strncmp(name, "package-", 8) || !pidef_energy_read(zone, "energy_uj", &energy->start[i])) continue;
+		if (!pidef_energy_read(zone, "max_energy_range_uj", &energy->range[i])) energy->range[i] = 0;
+		energy->zone[i] = zone;
+		++energy->zones;
+	}
+	#endif
+
+	energy->start_time = pidef_wall_seconds();
+	return energy->zones > 0;
+}
+
+void pidef_energy_stop(pidef_energy *energy) {
+	energy->seconds = pidef_wall_seconds() - energy->start_time;
+
+	uint64_t microjoules = 0;
+	for (int i = 0; i < energy->zones; ++i) {
+		uint64_t end;
+		if (!pidef_energy_read(energy->zone[i], "energy_uj", &end)) {
+			energy->zones = 0;
+			return;
+		}
+		microjoules += end >= energy->start[i] ? end - energy->start[i] : end + energy->range[i] - energy->start[i];
+	}
+	energy->joules = (double)microjoules * 1e-6;
+}
+
+void pidef_energy_print(const pidef_energy *energy, double work, const char *unit) {
+	if (!energy->zones) {
+		printf("Energy: unavailable\n");
+		return;
+	}
+
+	printf("Energy: %.3fJ over %d package(s), %.2fW average", energy->joules, energy->zones,
+		energy->seconds > 0.0 ? energy->joules / energy->seconds : 0.0);
+	if (energy->joules > 0.0) printf(", %.4g %s/J", work / energy->joules, unit);
+	putchar('\n');
+}
+
+#endif
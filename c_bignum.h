@@ -0,0 +1,1674 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Arbitrary precision integer arithmetic for the high-precision pi programs.
+
+   Numbers are stored as arrays of 32-bit 'limbs' (digits in base 2^32), least significant limb first.
+   The 'bn_' functions work on raw limb arrays (similar to GMP's 'mpn' layer) and the 'bigint_'
+   functions work on signed, heap-allocated 'bigint' values built on top of them.
+
+   Multiplication is split into tiers depending on the sizes of the operands:
+   - Schoolbook (basecase) multiplication for small operands.
+   - Karatsuba (Toom-22) multiplication for medium sized, balanced operands.
+   - Toom-33 for large, balanced operands.
+   - Unbalanced Toom-32, Toom-42 and Toom-63 for operands with size ratios of around 1.5 and 2.
+   - A chunked strategy for very lopsided operands, where the smaller operand is multiplied by
+     pieces of the larger one instead of being padded to the same size.
+   - Number theoretic transforms (NTT) over three primes for very large operands, combined with
+     the Chinese remainder theorem. Sums of two products (a * b + c * d) can be accumulated in the
+     transform domain, needing only a single inverse transform.
+
+   Newton iterations (reciprocals and inverse square roots) only need part of each product, so
+   'short' (high half) and 'middle' products skip the partial products of the columns that are not
+   needed, using whichever of the above tiers fits for the blocks that are needed in full.
+
+   Large buffers (multi-megabyte operands and transforms) are allocated with huge pages where the
+   OS supports them, reducing TLB misses when sweeping over them. This uses hugetlbfs pages if any are
+   reserved, otherwise transparent huge pages, falling back to normal allocations.
+
+   Large products can optionally be checked against silent hardware errors by comparing their residue
+   modulo a random 61-bit prime with the product of the operands' residues, recalculating products
+   that do not match (see bn_verify_enable).
+
+   See https://gmplib.org/manual/Multiplication-Algorithms and
+   https://en.wikipedia.org/wiki/Toom%E2%80%93Cook_multiplication for more information.
+*/
+
+#ifndef PI_C_BIGNUM_H
+#define PI_C_BIGNUM_H
+
+/* Needed for the mmap flags and madvise when compiling as strict C99. */
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
+/* Required includes. */
+#include "c_threads.h"
+#include "c_memory.h"
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+/* Types used for limbs and double-width intermediate results. */
+typedef uint32_t bn_limb;
+typedef uint64_t bn_dlimb;
+#define BN_LIMB_BITS 32
+
+/* Minimum operand sizes (in limbs) for each multiplication tier. */
+#define BN_KARATSUBA_THRESHOLD 32
+#define BN_TOOM33_THRESHOLD 128
+#define BN_TOOM63_THRESHOLD 384
+#define BN_NTT_THRESHOLD 12288
+
+/* Minimum size (in limbs) of numbers converted to decimal by divide and conquer instead of repeated division. */
+#define BN_GET_STR_THRESHOLD 64
+
+/* Allocations of at least this many bytes use huge pages by default. */
+#define BN_HUGE_PAGE_THRESHOLD ((size_t)4 << 20)
+
+/* Minimum operand sizes (in limbs) of products checked when verification is enabled, and how many times to retry them. */
+#define BN_VERIFY_THRESHOLD 1024
+#define BN_VERIFY_RETRIES 3
+
+/* Number of primes used by the NTT and the largest supported transform length (as a power of two). */
+#define BN_NTT_PRIMES 3
+#define BN_NTT_MAX_LOG2 24
+
+/* Transform buffers kept for reuse: at most this many of each length, and this many bytes in total by default. */
+#define BN_SCRATCH_PER_CLASS 8
+#define BN_SCRATCH_POOL_BYTES ((size_t)256 << 20)
+
+/* Signed arbitrary precision integer. */
+typedef struct {
+	bn_limb *limbs; /* Magnitude, least significant limb first. */
+	size_t size, capacity; /* Used and allocated number of limbs. A size of 0 is the value 0. */
+	int negative; /* Non-zero if the value is negative. */
+} bigint;
+
+
+/* Run-time huge page threshold in bytes. Set to SIZE_MAX to disable huge pages. */
+size_t bn_huge_page_bytes = BN_HUGE_PAGE_THRESHOLD;
+
+/*
+   Number of allocations above the huge page threshold, and how many got hugetlbfs or transparent huge pages.
+   Counted atomically, as the split threads allocate at the same time.
+*/
+uint64_t bn_large_allocs, bn_hugetlb_allocs, bn_thp_allocs;
+
+/* Run-time limit of the bytes kept in the transform buffer pool. Set to 0 to disable the pool. */
+size_t bn_scratch_pool_bytes = BN_SCRATCH_POOL_BYTES;
+
+/* Number of transform buffers that were newly allocated and that were reused from the pool. */
+unsigned long bn_scratch_allocs, bn_scratch_reuses;
+
+/* Prime used to check large products, or 0 if they are not checked. */
+uint64_t bn_verify_prime;
+
+/* Number of checked products, and how many of those calculations did not match. Counted atomically across the split threads. */
+uint64_t bn_verified_muls, bn_verify_failures;
+
+
+/*
+   Raw limb array functions declarations.
+   Unless stated otherwise, results may overlap the inputs if they start at the same address.
+*/
+
+/*
+   Allocates the given number of bytes, using huge pages for large sizes where possible.
+   Exits the program if there is not enough memory.
+*/
+void *bn_alloc_bytes(size_t bytes);
+
+/* Frees memory allocated with bn_alloc_bytes. Does nothing for NULL. */
+void bn_free_bytes(void *ptr);
+
+/* Allocates the given number of limbs, exiting the program if there is not enough memory. */
+bn_limb *bn_alloc(size_t n);
+
+/* Frees limbs allocated with bn_alloc. */
+void bn_free(bn_limb *limbs);
+
+/* Returns the given size without any most significant zero limbs. */
+size_t bn_normalized_size(const bn_limb *a, size_t n);
+
+/* Compares two arrays of the same size, returning -1, 0 or 1. */
+int bn_cmp(const bn_limb *a, const bn_limb *b, size_t n);
+
+/* r = a + b, for two arrays of size 'n'. Returns the carry. */
+bn_limb bn_add_n(bn_limb *r, const bn_limb *a, const bn_limb *b, size_t n);
+
+/* r = a + b, where 'an' >= 'bn'. 'r' has 'an' limbs and the carry is returned. */
+bn_limb bn_add(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn);
+
+/* r = a - b, for two arrays of size 'n'. Returns the borrow. */
+bn_limb bn_sub_n(bn_limb *r, const bn_limb *a, const bn_limb *b, size_t n);
+
+/* r = a - b, where 'an' >= 'bn'. 'r' has 'an' limbs and the borrow is returned. */
+bn_limb bn_sub(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn);
+
+/* r = a + limb, returning the carry. */
+bn_limb bn_add_1(bn_limb *r, const bn_limb *a, size_t n, bn_limb limb);
+
+/* r = a * m, returning the most significant (carry) limb. */
+bn_limb bn_mul_1(bn_limb *r, const bn_limb *a, size_t n, bn_limb m);
+
+/* r += a * m, returning the carry limb. 'r' must not overlap 'a'. */
+bn_limb bn_addmul_1(bn_limb *r, const bn_limb *a, size_t n, bn_limb m);
+
+/* r -= a * m, returning the borrow limb. 'r' must not overlap 'a'. */
+bn_limb bn_submul_1(bn_limb *r, const bn_limb *a, size_t n, bn_limb m);
+
+/* q = a / d, returning the remainder. */
+bn_limb bn_divrem_1(bn_limb *q, const bn_limb *a, size_t n, bn_limb d);
+
+/*
+   Multiplication functions.
+   All of these write 'an' + 'bn' limbs into 'r', which must not overlap the inputs,
+   and require 'an' >= 'bn' >= 1 unless stated otherwise.
+*/
+
+/* Schoolbook multiplication, O(an * bn). */
+void bn_mul_basecase(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn);
+
+/* Karatsuba multiplication. Requires 'an' + 1 < 2 * 'bn'. */
+void bn_mul_karatsuba(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn);
+
+/*
+   Toom-Cook multiplication splitting 'a' into 'm' pieces and 'b' into 'n' pieces, evaluated at
+   'm' + 'n' - 1 points (0, 1, -1, 2, -2, ... and infinity). The piece size is chosen so both operands
+   use all of their pieces, so Toom-32 (m = 3, n = 2), Toom-42 and Toom-63 need no padding for
+   operand size ratios of around 1.5 and 2. Falls back to chunked multiplication otherwise.
+*/
+void bn_mul_toom(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn, int m, int n);
+
+/* Multiplies 'b' by consecutive 'bn' sized pieces of 'a', accumulating the partial products. */
+void bn_mul_chunked(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn);
+
+/* Chooses the best multiplication tier for the given operand sizes. */
+void bn_mul(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn);
+
+/*
+   Calculates a * b + c * d (or a * b - c * d if 'subtract' is set) using number theoretic transforms,
+   writing 'rn' limbs of the absolute value into 'r' and returning non-zero if the result is negative.
+   Both products are accumulated pointwise in the transform domain and converted back once.
+   'c' may be NULL to calculate a single product. All operands must be non-empty, 'rn' must be large
+   enough for the result and the transform length of 2 * 'rn' 16-bit pieces must be supported.
+*/
+int bn_mul_sum_ntt(bn_limb *r, size_t rn, const bn_limb *a, size_t an, const bn_limb *b, size_t bn,
+	const bn_limb *c, size_t cn, const bn_limb *d, size_t dn, int subtract);
+
+/* Returns non-zero if an 'rn' limb result can be calculated with number theoretic transforms. */
+int bn_ntt_supported(size_t rn);
+
+/*
+   Returns a transform buffer of 'n' values (a power of two), reusing one from the pool if there is one.
+   Transforms also share a cached table of roots of unity for each prime, so they need no power calculations.
+*/
+uint32_t *bn_ntt_scratch_get(size_t n);
+
+/* Returns a buffer from bn_ntt_scratch_get to the pool, or frees it if the pool is full. */
+void bn_ntt_scratch_put(uint32_t *buffer, size_t n);
+
+/* Frees all pooled transform buffers and root of unity tables. No transforms may be running. */
+void bn_ntt_cache_free(void);
+
+/* Same as bn_mul, but allows operands in any order, of any size and with most significant zero limbs. */
+void bn_mul_any(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn);
+
+/*
+   Short product, writing 'an' + 'bn' - 'drop' limbs of floor(a * b / 2^(32 * drop)) into 'r'.
+   Partial products of the dropped columns are skipped, so the result may be 1 too small.
+   Operands may be in any order, but 'r' must not overlap them.
+*/
+void bn_mulhigh(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn, size_t drop);
+
+/*
+   Middle product, writing the 'high' - 'low' limbs of floor(a * b / 2^(32 * low)) mod 2^(32 * (high - low))
+   into 'r'. As with bn_mulhigh, the result may be 1 too small (modulo the kept limbs).
+*/
+void bn_mulmid(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn, size_t low, size_t high);
+
+/*
+   Long division (Knuth's algorithm D), calculating 'q' = 'a' / 'd' and 'r' = 'a' % 'd'.
+   Requires 'an' >= 'dn' and the top limb of 'd' to be non-zero. 'q' has 'an' - 'dn' + 1 limbs
+   and 'r' has 'dn' limbs; either may be NULL if not required.
+*/
+void bn_divrem(bn_limb *q, bn_limb *r, const bn_limb *a, size_t an, const bn_limb *d, size_t dn);
+
+/* Enables checking of large products, choosing a random 61-bit prime from the given seed. */
+void bn_verify_enable(uint64_t seed);
+
+/* Returns a * b mod p, where 'a' and 'b' are below 'p' and 'p' is below 2^63. */
+uint64_t bn_mulmod_prime(uint64_t a, uint64_t b, uint64_t p);
+
+/* Returns the given array modulo 'p', where 'p' is below 2^63. */
+uint64_t bn_mod_prime(const bn_limb *a, size_t n, uint64_t p);
+
+
+/*
+   Big integer functions declarations.
+   Results may be the same object as any of the inputs.
+*/
+
+/* Initializes the given integer to 0. */
+void bigint_init(bigint *x);
+
+/* Frees the memory used by the given integer. */
+void bigint_free(bigint *x);
+
+/* Ensures the given integer can store at least 'n' limbs, keeping its value. */
+void bigint_reserve(bigint *x, size_t n);
+
+/* Removes most significant zero limbs and the sign of zero. */
+void bigint_normalize(bigint *x);
+
+/* Swaps the values of two integers. */
+void bigint_swap(bigint *a, bigint *b);
+
+/* Sets 'x' to the given unsigned value. */
+void bigint_set_ui(bigint *x, uint64_t value);
+
+/* Sets 'x' to the non-negative value stored in a limb array. */
+void bigint_set_limbs(bigint *x, const bn_limb *limbs, size_t n);
+
+/* Copies the value of 'a' into 'r'. */
+void bigint_copy(bigint *r, const bigint *a);
+
+/* Compares the absolute values of 'a' and 'b', returning -1, 0 or 1. */
+int bigint_cmpabs(const bigint *a, const bigint *b);
+
+/* Returns the number of bits needed to store the absolute value of 'x'. */
+size_t bigint_bit_length(const bigint *x);
+
+/* r = a + b */
+void bigint_add(bigint *r, const bigint *a, const bigint *b);
+
+/* r = a - b */
+void bigint_sub(bigint *r, const bigint *a, const bigint *b);
+
+/* r = a * b */
+void bigint_mul(bigint *r, const bigint *a, const bigint *b);
+
+/* r = a * b + c * d, using a single inverse transform for large operands. 'r' must not be an input. */
+void bigint_mul_sum(bigint *r, const bigint *a, const bigint *b, const bigint *c, const bigint *d);
+
+/* r = a * m, where |m| < 2^32. */
+void bigint_mul_si(bigint *r, const bigint *a, long m);
+
+/* r = a / d, where |d| < 2^32 and 'd' divides 'a' exactly. */
+void bigint_divexact_si(bigint *r, const bigint *a, long d);
+
+/* r = a * 2^bits */
+void bigint_shl(bigint *r, const bigint *a, size_t bits);
+
+/* r = a / 2^bits, truncated towards zero. */
+void bigint_shr(bigint *r, const bigint *a, size_t bits);
+
+/* q = a / d, truncated towards zero. 'd' must not be zero. */
+void bigint_div(bigint *q, const bigint *a, const bigint *d);
+
+/* r = base^exponent */
+void bigint_pow_ui(bigint *r, bn_limb base, unsigned long exponent);
+
+/* r = floor(sqrt(a)), where 'a' is non-negative. */
+void bigint_sqrt(bigint *r, const bigint *a);
+
+/* r = a * b / 2^(32 * drop), using a short product. May be 1 closer to zero than the truncated result. */
+void bigint_mulhigh(bigint *r, const bigint *a, const bigint *b, size_t drop);
+
+/*
+   Sets 'r' to an approximation of 2^(32 * ('d' limbs + 'prec')) / |d| within a few units, using
+   Newton's iteration x = x + x(1 - dx) with a middle product for dx and a short product for the correction.
+*/
+void bigint_recip(bigint *r, const bigint *d, size_t prec);
+
+/*
+   Sets 'r' to an approximation of 2^(32 * 'prec') / sqrt(a) within a few units, using Newton's
+   iteration y = y + y(1 - ay^2) / 2 with a short product for the correction.
+*/
+void bigint_invsqrt_ui(bigint *r, bn_limb a, size_t prec);
+
+/*
+   Returns a malloc'd string of the decimal representation of 'x'. Large numbers are split in halves by powers of 10^9
+   recursively, dividing with Newton reciprocals of the powers, for O(M(n) log n) time instead of O(n^2).
+*/
+char *bigint_get_str(const bigint *x);
+
+
+/*
+   Raw limb array functions definitions.
+*/
+
+/* Bytes before each allocation storing its total size and how it was allocated, keeping 16-byte alignment. */
+#define BN_ALLOC_HEADER 16
+enum { bn_alloc_heap, bn_alloc_mapped };
+
+void *bn_alloc_bytes(size_t bytes) {
+	unsigned char *block = NULL;
+	size_t total = bytes + BN_ALLOC_HEADER;
+	int kind = bn_alloc_heap;
+
+	#ifdef __linux__
+	if (bytes >= bn_huge_page_bytes) {
+		/* Round up to a multiple of the (usual) 2 MiB huge page size. */
+		const size_t huge_size = (size_t)2 << 20;
+		const size_t mapped = (total + huge_size - 1) / huge_size * huge_size;
+		void *ptr = MAP_FAILED;
+		pidef_atomic_add(&bn_large_allocs, 1);
+
+		/* Reserved hugetlbfs pages first, otherwise normal pages with a transparent huge page hint. */
+		#ifdef MAP_HUGETLB
+		ptr = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (ptr != MAP_FAILED) pidef_atomic_add(&bn_hugetlb_allocs, 1);
+		#endif
+		if (ptr == MAP_FAILED) {
+			ptr = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			#ifdef MADV_HUGEPAGE
+			if (ptr != MAP_FAILED && !madvise(ptr, mapped, MADV_HUGEPAGE)) pidef_atomic_add(&bn_thp_allocs, 1);
+			#endif
+		}
+
+		if (ptr != MAP_FAILED) {
+			block = (unsigned char*)ptr;
+			total = mapped;
+			kind = bn_alloc_mapped;
+		}
+	}
+	#endif
+
+	if (!block) block = (unsigned char*)malloc(total);
+	if (!block) {
+		fprintf(stderr, "Could not allocate %lu bytes of memory.\n", (unsigned long)bytes);
+		exit(EXIT_FAILURE);
+	}
+
+	memcpy(block, &total, sizeof total);
+	memcpy(block + sizeof total, &kind, sizeof kind);
+	if (pidef_memory_tracking) pidef_memory_count_alloc(total);
+	return block + BN_ALLOC_HEADER;
+}
+
+void bn_free_bytes(void *ptr) {
+	if (!ptr) return;
+	unsigned char *const block = (unsigned char*)ptr - BN_ALLOC_HEADER;
+	size_t total;
+	int kind;
+	memcpy(&total, block, sizeof total);
+	memcpy(&kind, block + sizeof total, sizeof kind);
+	if (pidef_memory_tracking) pidef_memory_count_free(total);
+
+	#ifdef __linux__
+	if (kind == bn_alloc_mapped) {
+		munmap(block, total);
+		return;
+	}
+	#endif
+	free(block);
+}
+
+bn_limb *bn_alloc(size_t n) { return (bn_limb*)bn_alloc_bytes(n * sizeof(bn_limb)); }
+
+void bn_free(bn_limb *limbs) { bn_free_bytes(limbs); }
+
+size_t bn_normalized_size(const bn_limb *a, size_t n) {
+	while (n && !a[n - 1]) --n;
+	return n;
+}
+
+int bn_cmp(const bn_limb *a, const bn_limb *b, size_t n) {
+	while (n--) if (a[n] != b[n]) return a[n] > b[n] ? 1 : -1;
+	return 0;
+}
+
+bn_limb bn_add_n(bn_limb *r, const bn_limb *a, const bn_limb *b, size_t n) {
+	bn_dlimb carry = 0;
+	for (size_t i = 0; i < n; ++i) {
+		carry += (bn_dlimb)a[i] + b[i];
+		r[i] = (bn_limb)carry;
+		carry >>= BN_LIMB_BITS;
+	}
+	return (bn_limb)carry;
+}
+
+bn_limb bn_add(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn) {
+	bn_dlimb carry = bn_add_n(r, a, b, bn);
+	for (size_t i = bn; i < an; ++i) {
+		carry += a[i];
+		r[i] = (bn_limb)carry;
+		carry >>= BN_LIMB_BITS;
+	}
+	return (bn_limb)carry;
+}
+
+bn_limb bn_sub_n(bn_limb *r, const bn_limb *a, const bn_limb *b, size_t n) {
+	bn_dlimb borrow = 0;
+	for (size_t i = 0; i < n; ++i) {
+		const bn_dlimb diff = (bn_dlimb)a[i] - b[i] - borrow;
+		r[i] = (bn_limb)diff;
+		borrow = diff >> 63; /* Wrapped around if the top bit is set. */
+	}
+	return (bn_limb)borrow;
+}
+
+bn_limb bn_sub(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn) {
+	bn_dlimb borrow = bn_sub_n(r, a, b, bn);
+	for (size_t i = bn; i < an; ++i) {
+		const bn_dlimb diff = (bn_dlimb)a[i] - borrow;
+		r[i] = (bn_limb)diff;
+		borrow = diff >> 63;
+	}
+	return (bn_limb)borrow;
+}
+
+bn_limb bn_add_1(bn_limb *r, const bn_limb *a, size_t n, bn_limb limb) {
+	bn_dlimb carry = limb;
+	for (size_t i = 0; i < n; ++i) {
+		carry += a[i];
+		r[i] = (bn_limb)carry;
+		carry >>= BN_LIMB_BITS;
+	}
+	return (bn_limb)carry;
+}
+
+bn_limb bn_mul_1(bn_limb *r, const bn_limb *a, size_t n, bn_limb m) {
+	bn_dlimb carry = 0;
+	for (size_t i = 0; i < n; ++i) {
+		carry += (bn_dlimb)a[i] * m;
+		r[i] = (bn_limb)carry;
+		carry >>= BN_LIMB_BITS;
+	}
+	return (bn_limb)carry;
+}
+
+bn_limb bn_addmul_1(bn_limb *r, const bn_limb *a, size_t n, bn_limb m) {
+	bn_dlimb carry = 0;
+	for (size_t i = 0; i < n; ++i) {
+		carry += (bn_dlimb)a[i] * m + r[i]; /* Cannot overflow: (2^32 - 1)^2 + 2 * (2^32 - 1) = 2^64 - 1 */
+		r[i] = (bn_limb)carry;
+		carry >>= BN_LIMB_BITS;
+	}
+	return (bn_limb)carry;
+}
+
+bn_limb bn_submul_1(bn_limb *r, const bn_limb *a, size_t n, bn_limb m) {
+	bn_dlimb carry = 0;
+	for (size_t i = 0; i < n; ++i) {
+		const bn_dlimb prod = (bn_dlimb)a[i] * m + carry;
+		const bn_limb low = (bn_limb)prod;
+		carry = (prod >> BN_LIMB_BITS) + (r[i] < low);
+		r[i] -= low;
+	}
+	return (bn_limb)carry;
+}
+
+bn_limb bn_divrem_1(bn_limb *q, const bn_limb *a, size_t n, bn_limb d) {
+	bn_dlimb rem = 0;
+	while (n--) {
+		const bn_dlimb cur = (rem << BN_LIMB_BITS) | a[n];
+		q[n] = (bn_limb)(cur / d);
+		rem = cur % d;
+	}
+	return (bn_limb)rem;
+}
+
+void bn_mul_basecase(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn) {
+	r[an] = bn_mul_1(r, a, an, b[0]);
+	for (size_t i = 1; i < bn; ++i) r[an + i] = bn_addmul_1(r + i, a, an, b[i]);
+}
+
+void bn_mul_karatsuba(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn) {
+	/* Split both operands at 'h' limbs: a = a1 * X^h + a0 and b = b1 * X^h + b0. */
+	const size_t h = (an + 1) / 2, rn = an + bn;
+	const bn_limb *const a0 = a, *const a1 = a + h, *const b0 = b, *const b1 = b + h;
+
+	/* Low (a0 * b0) and high (a1 * b1) products are placed directly into the result. */
+	bn_mul_any(r, a0, h, b0, h);
+	bn_mul_any(r + 2 * h, a1, an - h, b1, bn - h);
+
+	/* Middle product: (a0 + a1)(b0 + b1) - a0 * b0 - a1 * b1 */
+	bn_limb *const sums = bn_alloc(4 * h + 4), *const sa = sums, *const sb = sums + h + 1, *const mid = sums + 2 * h + 2;
+	sa[h] = bn_add(sa, a0, h, a1, an - h);
+	sb[h] = bn_add(sb, b0, h, b1, bn - h);
+	bn_mul_any(mid, sa, h + 1, sb, h + 1);
+	bn_sub(mid, mid, 2 * h + 2, r, 2 * h);
+	bn_sub(mid, mid, 2 * h + 2, r + 2 * h, rn - 2 * h);
+
+	/* Add the middle product at its place. It is known to fit into the result's remaining limbs. */
+	bn_add(r + h, r + h, rn - h, mid, bn_normalized_size(mid, 2 * h + 2));
+	bn_free(sums);
+}
+
+/* Sets 'x' to the polynomial with 'count' 'size' limb coefficients of 'limbs' evaluated at 'point'. */
+static void bn_toom_evaluate(bigint *x, const bn_limb *limbs, size_t n, size_t size, int count, long point) {
+	bigint coeff;
+	bigint_init(&coeff);
+
+	/* Horner's method, starting from the (possibly shorter) most significant coefficient. */
+	const size_t top_start = size * (size_t)(count - 1);
+	bigint_set_limbs(x, limbs + top_start, n - top_start);
+	for (int i = count - 2; i >= 0 && point; --i) {
+		bigint_mul_si(x, x, point);
+		bigint_set_limbs(&coeff, limbs + size * (size_t)i, size);
+		bigint_add(x, x, &coeff);
+	}
+	if (!point) bigint_set_limbs(x, limbs, size);
+
+	bigint_free(&coeff);
+}
+
+void bn_mul_toom(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn, int m, int n) {
+	/* Pieces are large enough that both operands fit in 'm' and 'n' pieces respectively. */
+	const size_t a_size = (an + (size_t)m - 1) / (size_t)m, b_size = (bn + (size_t)n - 1) / (size_t)n;
+	const size_t s = a_size > b_size ? a_size : b_size;
+
+	/* Each operand needs a non-empty most significant piece, otherwise it would be padded. */
+	if (s * (size_t)(m - 1) >= an || s * (size_t)(n - 1) >= bn) {
+		bn_mul_chunked(r, a, an, b, bn);
+		return;
+	}
+
+	/* Number of finite points (0, 1, -1, 2, -2, ...). Infinity is used as the last point. */
+	enum { max_points = 8 };
+	const int points_count = m + n - 2;
+	long points[max_points];
+	bigint values[max_points + 1], eval_b;
+	for (int i = 0; i < points_count; ++i) points[i] = i & 1 ? (i + 1) / 2 : -(i / 2);
+	for (int i = 0; i <= points_count; ++i) bigint_init(values + i);
+	bigint_init(&eval_b);
+
+	/* Evaluate and multiply pointwise. The product at infinity is that of the most significant pieces. */
+	for (int i = 0; i < points_count; ++i) {
+		bn_toom_evaluate(values + i, a, an, s, m, points[i]);
+		bn_toom_evaluate(&eval_b, b, bn, s, n, points[i]);
+		bigint_mul(values + i, values + i, &eval_b);
+	}
+	bigint_set_limbs(values + points_count, a + s * (size_t)(m - 1), an - s * (size_t)(m - 1));
+	bigint_set_limbs(&eval_b, b + s * (size_t)(n - 1), bn - s * (size_t)(n - 1));
+	bigint_mul(values + points_count, values + points_count, &eval_b);
+
+	/* Remove the highest degree term (known from infinity) from the finite point values. */
+	for (int i = 1; i < points_count; ++i) {
+		long power = 1;
+		for (int j = 0; j < points_count; ++j) power *= points[i];
+		bigint_mul_si(&eval_b, values + points_count, power);
+		bigint_sub(values + i, values + i, &eval_b);
+	}
+
+	/* Interpolate the remaining polynomial using Newton's divided differences. All divisions are exact. */
+	for (int j = 1; j < points_count; ++j) {
+		for (int i = points_count - 1; i >= j; --i) {
+			bigint_sub(values + i, values + i, values + i - 1);
+			bigint_divexact_si(values + i, values + i, points[i] - points[i - j]);
+		}
+	}
+
+	/* Convert from the Newton form into the product's coefficients, in place. */
+	for (int i = points_count - 2; i >= 0; --i) {
+		/* Multiply the polynomial of coefficients [i + 1, points_count) by (x - points[i]) and add values[i]. */
+		for (int j = i; j < points_count - 1; ++j) {
+			bigint_mul_si(&eval_b, values + j + 1, points[i]);
+			bigint_sub(values + j, values + j, &eval_b);
+		}
+	}
+
+	/* Recompose the result from the (non-negative) coefficients. */
+	const size_t rn = an + bn;
+	memset(r, 0, rn * sizeof *r);
+	for (int i = 0; i <= points_count; ++i) {
+		const size_t offset = s * (size_t)i;
+		if (values[i].size) bn_add(r + offset, r + offset, rn - offset, values[i].limbs, values[i].size);
+		bigint_free(values + i);
+	}
+	bigint_free(&eval_b);
+}
+
+void bn_mul_chunked(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn) {
+	bn_limb *const partial = bn_alloc(2 * bn);
+	memset(r, 0, (an + bn) * sizeof *r);
+
+	for (size_t offset = 0; offset < an; offset += bn) {
+		const size_t piece = an - offset < bn ? an - offset : bn;
+		bn_mul_any(partial, a + offset, piece, b, bn);
+		bn_add(r + offset, r + offset, an + bn - offset, partial, piece + bn);
+	}
+
+	bn_free(partial);
+}
+
+/* Primes of the form k * 2^n + 1 (n >= BN_NTT_MAX_LOG2) and their primitive roots. */
+static const uint32_t bn_ntt_primes[BN_NTT_PRIMES] = { 469762049u, 167772161u, 754974721u };
+static const uint32_t bn_ntt_roots[BN_NTT_PRIMES] = { 3u, 3u, 11u };
+
+/* Returns base^exp mod p. */
+static uint32_t bn_ntt_powmod(uint32_t base, uint64_t exp, uint32_t p) {
+	uint64_t result = 1, power = base % p;
+	for (; exp; exp >>= 1, power = power * power % p) if (exp & 1) result = result * power % p;
+	return (uint32_t)result;
+}
+
+/*
+   Cached powers of each prime's root of unity. The table of a prime holds the first half of the powers of
+   the primitive root for the longest transform so far, from which every shorter transform takes a stride.
+   A longer transform replaces the table, but the old one is only retired, as other threads may still read it.
+*/
+static uint32_t *bn_ntt_tables[BN_NTT_PRIMES];
+static size_t bn_ntt_table_sizes[BN_NTT_PRIMES];
+static uint32_t *bn_ntt_retired[BN_NTT_PRIMES * BN_NTT_MAX_LOG2];
+static size_t bn_ntt_retired_count;
+static pidef_mutex_t bn_ntt_table_lock = PIDEF_MUTEX_INIT;
+
+/* Returns the root table of the given prime for transforms of up to 'n' values, and its number of powers. */
+static const uint32_t *bn_ntt_root_table(int prime, size_t n, size_t *size) {
+	pidef_mutex_lock(&bn_ntt_table_lock);
+	if (bn_ntt_table_sizes[prime] < n / 2) {
+		const uint32_t p = bn_ntt_primes[prime], w = bn_ntt_powmod(bn_ntt_roots[prime], (p - 1) / n, p);
+		uint32_t *const table = (uint32_t*)bn_alloc_bytes(n / 2 * sizeof(uint32_t));
+		uint64_t cur = 1;
+		for (size_t j = 0; j < n / 2; ++j, cur = cur * w % p) table[j] = (uint32_t)cur;
+
+		if (bn_ntt_tables[prime]) bn_ntt_retired[bn_ntt_retired_count++] = bn_ntt_tables[prime];
+		bn_ntt_tables[prime] = table;
+		bn_ntt_table_sizes[prime] = n / 2;
+	}
+
+	const uint32_t *const table = bn_ntt_tables[prime];
+	*size = bn_ntt_table_sizes[prime];
+	pidef_mutex_unlock(&bn_ntt_table_lock);
+	return table;
+}
+
+/* Pooled transform buffers for each power of two length, and the total bytes they take. */
+static uint32_t *bn_scratch_pool[BN_NTT_MAX_LOG2 + 1][BN_SCRATCH_PER_CLASS];
+static int bn_scratch_counts[BN_NTT_MAX_LOG2 + 1];
+static size_t bn_scratch_pooled_bytes;
+static pidef_mutex_t bn_scratch_lock = PIDEF_MUTEX_INIT;
+
+/* Returns the pool index of 'n' values (a power of two). */
+static int bn_scratch_class(size_t n) {
+	int log2 = 0;
+	while (((size_t)1 << log2) < n) ++log2;
+	return log2;
+}
+
+uint32_t *bn_ntt_scratch_get(size_t n) {
+	const int index = bn_scratch_class(n);
+	uint32_t *buffer = NULL;
+
+	pidef_mutex_lock(&bn_scratch_lock);
+	if (bn_scratch_counts[index]) {
+		buffer = bn_scratch_pool[index][--bn_scratch_counts[index]];
+		bn_scratch_pooled_bytes -= n * sizeof(uint32_t);
+		++bn_scratch_reuses;
+	} else ++bn_scratch_allocs;
+	pidef_mutex_unlock(&bn_scratch_lock);
+
+	return buffer ? buffer : (uint32_t*)bn_alloc_bytes(n * sizeof(uint32_t));
+}
+
+void bn_ntt_scratch_put(uint32_t *buffer, size_t n) {
+	const int index = bn_scratch_class(n);
+	const size_t bytes = n * sizeof(uint32_t);
+
+	pidef_mutex_lock(&bn_scratch_lock);
+	const int keep = bn_scratch_counts[index] < BN_SCRATCH_PER_CLASS && bn_scratch_pooled_bytes + bytes <= bn_scratch_pool_bytes;
+	if (keep) {
+		bn_scratch_pool[index][bn_scratch_counts[index]++] = buffer;
+		bn_scratch_pooled_bytes += bytes;
+	}
+	pidef_mutex_unlock(&bn_scratch_lock);
+
+	if (!keep) bn_free_bytes(buffer);
+}
+
+void bn_ntt_cache_free(void) {
+	for (int i = 0; i <= BN_NTT_MAX_LOG2; ++i) {
+		while (bn_scratch_counts[i]) bn_free_bytes(bn_scratch_pool[i][--bn_scratch_counts[i]]);
+	}
+	bn_scratch_pooled_bytes = 0;
+
+	for (int k = 0; k < BN_NTT_PRIMES; ++k) {
+		bn_free_bytes(bn_ntt_tables[k]);
+		bn_ntt_tables[k] = NULL;
+		bn_ntt_table_sizes[k] = 0;
+	}
+	while (bn_ntt_retired_count) bn_free_bytes(bn_ntt_retired[--bn_ntt_retired_count]);
+}
+
+/*
+   Forward transform (decimation in frequency), leaving the result in bit-reversed order.
+   The powers of each stage are gathered from the cached table into 'twiddles' (n / 2 values) so the
+   butterflies read them contiguously, except when the table already has the right spacing.
+*/
+static void bn_ntt_forward(uint32_t *a, size_t n, int prime, uint32_t *twiddles) {
+	const uint32_t p = bn_ntt_primes[prime];
+	size_t table_size;
+	const uint32_t *const table = bn_ntt_root_table(prime, n, &table_size);
+
+	for (size_t len = n; len >= 2; len >>= 1) {
+		const size_t half = len / 2, stride = table_size / half;
+		const uint32_t *w = table;
+		if (stride != 1) {
+			for (size_t j = 0; j < half; ++j) twiddles[j] = table[j * stride];
+			w = twiddles;
+		}
+
+		for (size_t i = 0; i < n; i += len) {
+			for (size_t j = 0; j < half; ++j) {
+				const uint32_t u = a[i + j], v = a[i + j + half];
+				a[i + j] = u + v >= p ? u + v - p : u + v;
+				a[i + j + half] = (uint32_t)((uint64_t)(u + p - v) * w[j] % p);
+			}
+		}
+	}
+}
+
+/*
+   Inverse transform (decimation in time) of bit-reversed input, including the division by 'n'.
+   Inverse powers come from the same table, as w^-j = w^(len - j) = -w^(len / 2 - j) for a 'len'-th root w.
+*/
+static void bn_ntt_inverse(uint32_t *a, size_t n, int prime, uint32_t *twiddles) {
+	const uint32_t p = bn_ntt_primes[prime];
+	size_t table_size;
+	const uint32_t *const table = bn_ntt_root_table(prime, n, &table_size);
+
+	for (size_t len = 2; len <= n; len <<= 1) {
+		const size_t half = len / 2, stride = table_size / half;
+		twiddles[0] = 1;
+		for (size_t j = 1; j < half; ++j) twiddles[j] = p - table[(half - j) * stride];
+
+		for (size_t i = 0; i < n; i += len) {
+			for (size_t j = 0; j < half; ++j) {
+				const uint32_t u = a[i + j], v = (uint32_t)((uint64_t)a[i + j + half] * twiddles[j] % p);
+				a[i + j] = u + v >= p ? u + v - p : u + v;
+				a[i + j + half] = u >= v ? u - v : u + p - v;
+			}
+		}
+	}
+
+	/* As 'n' divides p - 1, its inverse is p - (p - 1) / n. */
+	const uint64_t n_inv = p - (p - 1) / n;
+	for (size_t i = 0; i < n; ++i) a[i] = (uint32_t)(a[i] * n_inv % p);
+}
+
+/* Splits the limbs into 16-bit pieces, padded with zeros to 'n' values, and applies the forward transform. */
+static void bn_ntt_load(uint32_t *t, const bn_limb *a, size_t an, size_t n, int prime, uint32_t *twiddles) {
+	for (size_t i = 0; i < an; ++i) {
+		t[2 * i] = a[i] & 0xFFFFu;
+		t[2 * i + 1] = a[i] >> 16;
+	}
+	memset(t + 2 * an, 0, (n - 2 * an) * sizeof *t);
+	bn_ntt_forward(t, n, prime, twiddles);
+}
+
+int bn_ntt_supported(size_t rn) { return rn <= ((size_t)1 << (BN_NTT_MAX_LOG2 - 1)); }
+
+int bn_mul_sum_ntt(bn_limb *r, size_t rn, const bn_limb *a, size_t an, const bn_limb *b, size_t bn,
+	const bn_limb *c, size_t cn, const bn_limb *d, size_t dn, int subtract)
+{
+	size_t n = 1;
+	while (n < 2 * rn) n <<= 1;
+
+	/* Residues of the result for each prime, and scratch space for the other transforms, from the buffer pool. */
+	uint32_t *residues[BN_NTT_PRIMES];
+	for (int k = 0; k < BN_NTT_PRIMES; ++k) residues[k] = bn_ntt_scratch_get(n);
+	uint32_t *const twiddles = bn_ntt_scratch_get(n / 2), *const tb = bn_ntt_scratch_get(n);
+	uint32_t *const tc = c ? bn_ntt_scratch_get(n) : NULL, *const td = c ? bn_ntt_scratch_get(n) : NULL;
+
+	for (int k = 0; k < BN_NTT_PRIMES; ++k) {
+		const uint32_t p = bn_ntt_primes[k];
+		uint32_t *const ta = residues[k];
+		bn_ntt_load(ta, a, an, n, k, twiddles);
+		bn_ntt_load(tb, b, bn, n, k, twiddles);
+
+		if (c) {
+			/* Accumulate both products pointwise, so only one inverse transform is needed. */
+			bn_ntt_load(tc, c, cn, n, k, twiddles);
+			bn_ntt_load(td, d, dn, n, k, twiddles);
+			for (size_t i = 0; i < n; ++i) {
+				const uint32_t ab = (uint32_t)((uint64_t)ta[i] * tb[i] % p), cd = (uint32_t)((uint64_t)tc[i] * td[i] % p);
+				if (subtract) ta[i] = ab >= cd ? ab - cd : ab + p - cd;
+				else ta[i] = ab + cd >= p ? ab + cd - p : ab + cd;
+			}
+		} else for (size_t i = 0; i < n; ++i) ta[i] = (uint32_t)((uint64_t)ta[i] * tb[i] % p);
+
+		bn_ntt_inverse(ta, n, k, twiddles);
+	}
+
+	/* Constants for combining the residues with Garner's algorithm. */
+	const uint64_t p1 = bn_ntt_primes[0], p2 = bn_ntt_primes[1], p3 = bn_ntt_primes[2], p12 = p1 * p2;
+	const uint64_t p1_inv = bn_ntt_powmod((uint32_t)(p1 % p2), p2 - 2, (uint32_t)p2);
+	const uint64_t p12_inv = bn_ntt_powmod((uint32_t)(p12 % p3), p3 - 2, (uint32_t)p3);
+	const uint64_t modulus_low = p12 * p3; /* Product of all primes, modulo 2^64. */
+
+	/*
+	   Each 16-bit piece of the result has an absolute value below 2^57, far below half of the primes' product,
+	   so values in the upper half are negative (from a subtraction). These fit into a signed 64-bit carry.
+	*/
+	int64_t carry = 0;
+	memset(r, 0, rn * sizeof *r);
+	for (size_t i = 0; i < 2 * rn; ++i) {
+		if (i < n) {
+			const uint64_t r1 = residues[0][i], r2 = residues[1][i], r3 = residues[2][i];
+			const uint64_t t2 = (r2 + p2 - r1 % p2) % p2 * p1_inv % p2, x12 = r1 + p1 * t2;
+			const uint64_t t3 = (r3 + p3 - x12 % p3) % p3 * p12_inv % p3;
+			uint64_t value = x12 + p12 * t3;
+			if (t3 > p3 / 2) value -= modulus_low;
+			carry += (int64_t)value;
+		}
+
+		const uint64_t piece = (uint64_t)carry & 0xFFFFu;
+		carry = (carry - (int64_t)piece) / 65536;
+		r[i / 2] |= (bn_limb)(piece << (i & 1 ? 16 : 0));
+	}
+
+	/* A negative result is stored in two's complement form. */
+	const int negative = carry < 0;
+	if (negative) {
+		for (size_t i = 0; i < rn; ++i) r[i] = ~r[i];
+		bn_add_1(r, r, rn, 1);
+	}
+
+	for (int k = 0; k < BN_NTT_PRIMES; ++k) bn_ntt_scratch_put(residues[k], n);
+	bn_ntt_scratch_put(twiddles, n / 2);
+	bn_ntt_scratch_put(tb, n);
+	if (c) {
+		bn_ntt_scratch_put(tc, n);
+		bn_ntt_scratch_put(td, n);
+	}
+	return negative;
+}
+
+void bn_mul(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn) {
+	if (bn < BN_KARATSUBA_THRESHOLD) bn_mul_basecase(r, a, an, b, bn);
+	else if (bn >= BN_NTT_THRESHOLD && bn_ntt_supported(an + bn)) bn_mul_sum_ntt(r, an + bn, a, an, b, bn, NULL, 0, NULL, 0, 0);
+	else if (bn < BN_TOOM33_THRESHOLD) {
+		if (an + 1 < 2 * bn) bn_mul_karatsuba(r, a, an, b, bn);
+		else bn_mul_chunked(r, a, an, b, bn);
+	}
+	else if (4 * an < 5 * bn) bn_mul_toom(r, a, an, b, bn, 3, 3); /* Ratio < 1.25 */
+	else if (4 * an < 7 * bn) bn_mul_toom(r, a, an, b, bn, 3, 2); /* Ratio < 1.75 */
+	else if (2 * an < 5 * bn) { /* Ratio < 2.5 */
+		if (bn < BN_TOOM63_THRESHOLD) bn_mul_toom(r, a, an, b, bn, 4, 2);
+		else bn_mul_toom(r, a, an, b, bn, 6, 3);
+	}
+	else bn_mul_chunked(r, a, an, b, bn);
+}
+
+void bn_mul_any(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn) {
+	const size_t rn = an + bn;
+	an = bn_normalized_size(a, an);
+	bn = bn_normalized_size(b, bn);
+
+	if (!an || !bn) {
+		memset(r, 0, rn * sizeof *r);
+		return;
+	}
+
+	if (an >= bn) bn_mul(r, a, an, b, bn);
+	else bn_mul(r, b, bn, a, an);
+	memset(r + an + bn, 0, (rn - an - bn) * sizeof *r);
+}
+
+/*
+   Adds the columns [base, top) of a * b * 2^(32 * offset) into 'acc', which stores 'top' - 'base' limbs.
+   Blocks of partial products completely outside of those columns are skipped and blocks completely inside
+   use a full multiplication, otherwise the operands are halved until they are small enough for a basecase
+   loop that skips the unneeded columns. Carries out of the skipped lower columns are lost.
+*/
+static void bn_mul_band(bn_limb *acc, size_t base, size_t top, const bn_limb *a, size_t an, const bn_limb *b, size_t bn, size_t offset) {
+	if (!an || !bn || offset >= top || offset + an + bn <= base) return;
+	const size_t acc_n = top - base;
+
+	if (offset >= base && offset + an + bn <= top) {
+		/* Completely inside: full product. */
+		bn_limb *const prod = bn_alloc(an + bn);
+		bn_mul_any(prod, a, an, b, bn);
+		bn_add(acc + offset - base, acc + offset - base, acc_n - (offset - base), prod, an + bn);
+		bn_free(prod);
+	} else if (an >= BN_NTT_THRESHOLD && bn >= BN_NTT_THRESHOLD && bn_ntt_supported(an + bn)) {
+		/* Transforms cost the same for any part of the product, so the needed columns are taken from a full one. */
+		bn_limb *const prod = bn_alloc(an + bn);
+		bn_mul_any(prod, a, an, b, bn);
+		const size_t start = base > offset ? base - offset : 0, end = top - offset < an + bn ? top - offset : an + bn;
+		bn_add(acc + offset + start - base, acc + offset + start - base, acc_n - (offset + start - base), prod + start, end - start);
+		bn_free(prod);
+	} else if (an < BN_KARATSUBA_THRESHOLD || bn < BN_KARATSUBA_THRESHOLD) {
+		/* Basecase, only multiplying the limbs of 'a' whose columns are within the band for each limb of 'b'. */
+		for (size_t j = 0; j < bn; ++j) {
+			const size_t col = offset + j;
+			const size_t start = base > col ? base - col : 0, end = top - col < an ? top - col : an;
+			if (col >= top) break;
+			if (start >= end) continue;
+
+			const size_t pos = col + start - base, len = end - start;
+			const bn_limb carry = bn_addmul_1(acc + pos, a + start, len, b[j]);
+			if (pos + len < acc_n) bn_add_1(acc + pos + len, acc + pos + len, acc_n - pos - len, carry);
+		}
+	} else {
+		/* Split the larger operand (or both if they are similar in size) into halves. */
+		const size_t ah = bn >= 2 * an ? an : an / 2, bh = an >= 2 * bn ? bn : bn / 2;
+		bn_mul_band(acc, base, top, a, ah, b, bh, offset);
+		bn_mul_band(acc, base, top, a + ah, an - ah, b, bh, offset + ah);
+		bn_mul_band(acc, base, top, a, ah, b + bh, bn - bh, offset + bh);
+		bn_mul_band(acc, base, top, a + ah, an - ah, b + bh, bn - bh, offset + ah + bh);
+	}
+}
+
+/* Guard limbs below the kept columns of short and middle products, bounding the lost carries to 1. */
+#define BN_BAND_GUARD 2
+
+void bn_mulhigh(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn, size_t drop) {
+	bn_mulmid(r, a, an, b, bn, drop, an + bn);
+}
+
+void bn_mulmid(bn_limb *r, const bn_limb *a, size_t an, const bn_limb *b, size_t bn, size_t low, size_t high) {
+	const size_t guard = low < BN_BAND_GUARD ? low : BN_BAND_GUARD, base = low - guard;
+	bn_limb *const acc = bn_alloc(high - base);
+	memset(acc, 0, (high - base) * sizeof *acc);
+
+	bn_mul_band(acc, base, high, a, an, b, bn, 0);
+	memcpy(r, acc + guard, (high - low) * sizeof *r);
+	bn_free(acc);
+}
+
+void bn_divrem(bn_limb *q, bn_limb *r, const bn_limb *a, size_t an, const bn_limb *d, size_t dn) {
+	const bn_dlimb base = (bn_dlimb)1 << BN_LIMB_BITS;
+
+	/* Single limb divisors are much simpler. */
+	if (dn == 1) {
+		bn_limb *const quot = q ? q : bn_alloc(an);
+		const bn_limb rem = bn_divrem_1(quot, a, an, *d);
+		if (r) *r = rem;
+		if (!q) bn_free(quot);
+		return;
+	}
+
+	/* Normalize so that the divisor's top bit is set, giving better quotient limb estimates. */
+	int shift = 0;
+	while (!(d[dn - 1] << shift & 0x80000000u)) ++shift;
+
+	bn_limb *const un = bn_alloc(an + 1), *const vn = bn_alloc(dn);
+	for (size_t i = dn - 1; i > 0; --i) vn[i] = (bn_limb)((d[i] << shift) | ((bn_dlimb)d[i - 1] >> (BN_LIMB_BITS - shift)));
+	vn[0] = d[0] << shift;
+	un[an] = (bn_limb)((bn_dlimb)a[an - 1] >> (BN_LIMB_BITS - shift));
+	for (size_t i = an - 1; i > 0; --i) un[i] = (bn_limb)((a[i] << shift) | ((bn_dlimb)a[i - 1] >> (BN_LIMB_BITS - shift)));
+	un[0] = a[0] << shift;
+
+	for (size_t j = an - dn + 1; j-- > 0;) {
+		/* Estimate the quotient limb from the top two limbs, correcting it at most twice. */
+		const bn_dlimb top = ((bn_dlimb)un[j + dn] << BN_LIMB_BITS) | un[j + dn - 1];
+		bn_dlimb qhat = top / vn[dn - 1], rhat = top % vn[dn - 1];
+		while (qhat >= base || qhat * vn[dn - 2] > ((rhat << BN_LIMB_BITS) | un[j + dn - 2])) {
+			--qhat;
+			rhat += vn[dn - 1];
+			if (rhat >= base) break;
+		}
+
+		/* Multiply and subtract, adding back if the estimate was still one too large. */
+		const bn_limb borrow = bn_submul_1(un + j, vn, dn, (bn_limb)qhat);
+		const bn_limb top_limb = un[j + dn];
+		un[j + dn] = top_limb - borrow;
+		if (top_limb < borrow) {
+			--qhat;
+			un[j + dn] += bn_add_n(un + j, un + j, vn, dn);
+		}
+		if (q) q[j] = (bn_limb)qhat;
+	}
+
+	/* Undo the normalization of the remainder. */
+	if (r) {
+		for (size_t i = 0; i < dn - 1; ++i) r[i] = (bn_limb)((un[i] >> shift) | ((bn_dlimb)un[i + 1] << (BN_LIMB_BITS - shift)));
+		r[dn - 1] = un[dn - 1] >> shift;
+	}
+
+	bn_free(un);
+	bn_free(vn);
+}
+
+/* Unsigned 128-bit integers for modular products, where the compiler supports them. */
+#ifdef __SIZEOF_INT128__
+__extension__ typedef unsigned __int128 bn_qlimb;
+#define BN_HAVE_QLIMB
+#endif
+
+uint64_t bn_mulmod_prime(uint64_t a, uint64_t b, uint64_t p) {
+	#ifdef BN_HAVE_QLIMB
+	return (uint64_t)((bn_qlimb)a * b % p);
+	#else
+	/* Double and add, which cannot overflow as 'p' is below 2^63. */
+	uint64_t r = 0;
+	for (; b; b >>= 1) {
+		if (b & 1 && (r += a) >= p) r -= p;
+		if ((a += a) >= p) a -= p;
+	}
+	return r;
+	#endif
+}
+
+/* Returns base^exponent mod p. */
+static uint64_t bn_powmod_prime(uint64_t base, uint64_t exponent, uint64_t p) {
+	uint64_t result = 1 % p;
+	for (base %= p; exponent; exponent >>= 1) {
+		if (exponent & 1) result = bn_mulmod_prime(result, base, p);
+		base = bn_mulmod_prime(base, base, p);
+	}
+	return result;
+}
+
+/* Deterministic Miller-Rabin primality test, using bases that are enough for any 64-bit number. */
+static int bn_is_prime_u64(uint64_t n) {
+	static const uint64_t bases[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37 };
+	if (n < 2) return 0;
+	for (size_t i = 0; i < sizeof bases / sizeof *bases; ++i) if (n % bases[i] == 0) return n == bases[i];
+
+	uint64_t odd = n - 1;
+	int twos = 0;
+	for (; !(odd & 1); odd >>= 1) ++twos;
+
+	for (size_t i = 0; i < sizeof bases / sizeof *bases; ++i) {
+		uint64_t x = bn_powmod_prime(bases[i], odd, n);
+		if (x == 1 || x == n - 1) continue;
+		int j = 1;
+		for (; j < twos && (x = bn_mulmod_prime(x, x, n)) != n - 1; ++j);
+		if (j == twos) return 0;
+	}
+
+	return 1;
+}
+
+void bn_verify_enable(uint64_t seed) {
+	/* Mix the seed's bits (SplitMix64), then use the next prime after a random odd number between 2^60 and 2^61. */
+	uint64_t z = seed + UINT64_C(0x9E3779B97F4A7C15);
+	z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+	z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+	z ^= z >> 31;
+
+	uint64_t candidate = (z >> 4) | ((uint64_t)1 << 60) | 1;
+	while (!bn_is_prime_u64(candidate)) candidate += 2;
+	bn_verify_prime = candidate;
+}
+
+uint64_t bn_mod_prime(const bn_limb *a, size_t n, uint64_t p) {
+	/* Horner's method over 64-bit words (pairs of limbs), so each step multiplies by 2^64 mod p. */
+	const uint64_t base = (UINT64_MAX % p + 1) % p;
+	const size_t words = (n + 1) / 2;
+	#define BN_MOD_WORD(i) ((((uint64_t)(2 * (i) + 1 < n ? a[2 * (i) + 1] : 0) << 32) | a[2 * (i)]) % p)
+
+	/*
+	   The words are split into 4 chunks reduced together, as their steps are independent and can run
+	   in parallel in the CPU. Any words above the 4 chunks are reduced first.
+	*/
+	const size_t chunk = words / 4;
+	uint64_t top = 0, sums[4] = { 0, 0, 0, 0 };
+	for (size_t i = words; i-- > 4 * chunk;) top = (bn_mulmod_prime(top, base, p) + BN_MOD_WORD(i)) % p;
+
+	for (size_t i = chunk; i-- > 0;) {
+		for (int c = 0; c < 4; ++c) sums[c] = (bn_mulmod_prime(sums[c], base, p) + BN_MOD_WORD(c * chunk + i)) % p;
+	}
+	#undef BN_MOD_WORD
+
+	/* Combine the chunks, each being 'chunk' words above the previous one. */
+	const uint64_t shift = bn_powmod_prime(base, chunk, p);
+	for (int c = 3; c >= 0; --c) top = (bn_mulmod_prime(top, shift, p) + sums[c]) % p;
+	return top;
+}
+
+
+/*
+   Big integer functions definitions.
+*/
+
+void bigint_init(bigint *x) {
+	x->limbs = NULL;
+	x->size = x->capacity = 0;
+	x->negative = 0;
+}
+
+void bigint_free(bigint *x) {
+	bn_free(x->limbs);
+	bigint_init(x);
+}
+
+void bigint_reserve(bigint *x, size_t n) {
+	if (n <= x->capacity) return;
+	bn_limb *const limbs = bn_alloc(n);
+	if (x->size) memcpy(limbs, x->limbs, x->size * sizeof *limbs);
+	bn_free(x->limbs);
+	x->limbs = limbs;
+	x->capacity = n;
+}
+
+void bigint_normalize(bigint *x) {
+	x->size = bn_normalized_size(x->limbs, x->size);
+	if (!x->size) x->negative = 0;
+}
+
+void bigint_swap(bigint *a, bigint *b) {
+	const bigint temp = *a;
+	*a = *b;
+	*b = temp;
+}
+
+void bigint_set_ui(bigint *x, uint64_t value) {
+	bigint_reserve(x, 2);
+	x->limbs[0] = (bn_limb)value;
+	x->limbs[1] = (bn_limb)(value >> BN_LIMB_BITS);
+	x->size = 2;
+	x->negative = 0;
+	bigint_normalize(x);
+}
+
+void bigint_set_limbs(bigint *x, const bn_limb *limbs, size_t n) {
+	bigint_reserve(x, n);
+	memmove(x->limbs, limbs, n * sizeof *limbs);
+	x->size = n;
+	x->negative = 0;
+	bigint_normalize(x);
+}
+
+void bigint_copy(bigint *r, const bigint *a) {
+	if (r == a) return;
+	bigint_set_limbs(r, a->limbs, a->size);
+	r->negative = a->negative;
+}
+
+int bigint_cmpabs(const bigint *a, const bigint *b) {
+	if (a->size != b->size) return a->size > b->size ? 1 : -1;
+	return bn_cmp(a->limbs, b->limbs, a->size);
+}
+
+size_t bigint_bit_length(const bigint *x) {
+	if (!x->size) return 0;
+	size_t bits = (x->size - 1) * BN_LIMB_BITS;
+	for (bn_limb top = x->limbs[x->size - 1]; top; top >>= 1) ++bits;
+	return bits;
+}
+
+/* r = a + b, where 'b' is negated if 'b_negate' is set. */
+static void bigint_addsub(bigint *r, const bigint *a, const bigint *b, int b_negate) {
+	const int a_neg = a->negative, b_neg = b->negative ^ (b_negate && b->size);
+
+	if (a_neg == b_neg) {
+		/* Same signs: add magnitudes and keep the sign. */
+		const bigint *const big = a->size >= b->size ? a : b, *const small = big == a ? b : a;
+		const size_t big_size = big->size, small_size = small->size;
+		bigint_reserve(r, big_size + 1);
+		r->limbs[big_size] = bn_add(r->limbs, big->limbs, big_size, small->limbs, small_size);
+		r->size = big_size + 1;
+		r->negative = a_neg;
+	} else {
+		/* Different signs: subtract the smaller magnitude from the larger one. */
+		const int cmp = bigint_cmpabs(a, b);
+		const bigint *const big = cmp >= 0 ? a : b, *const small = big == a ? b : a;
+		const size_t big_size = big->size, small_size = small->size;
+		bigint_reserve(r, big_size);
+		bn_sub(r->limbs, big->limbs, big_size, small->limbs, small_size);
+		r->size = big_size;
+		r->negative = cmp >= 0 ? a_neg : b_neg;
+	}
+
+	bigint_normalize(r);
+}
+
+void bigint_add(bigint *r, const bigint *a, const bigint *b) { bigint_addsub(r, a, b, 0); }
+
+void bigint_sub(bigint *r, const bigint *a, const bigint *b) { bigint_addsub(r, a, b, 1); }
+
+/* Returns 'x' modulo the verification prime, taking its sign into account. */
+static uint64_t bigint_mod_verify(const bigint *x) {
+	const uint64_t r = bn_mod_prime(x->limbs, x->size, bn_verify_prime);
+	return x->negative && r ? bn_verify_prime - r : r;
+}
+
+/* Returns non-zero if a product of operands with the given sizes should be checked. */
+static int bigint_verify_wanted(const bigint *a, const bigint *b) {
+	return bn_verify_prime && a->size >= BN_VERIFY_THRESHOLD && b->size >= BN_VERIFY_THRESHOLD;
+}
+
+/*
+   Returns non-zero if the given result matches the expected residue. Exits the program
+   if the result was wrong on the last allowed attempt.
+*/
+static int bigint_verify_result(const bigint *r, uint64_t expected, int attempt) {
+	if (bigint_mod_verify(r) == expected) {
+		pidef_atomic_add(&bn_verified_muls, 1);
+		return 1;
+	}
+
+	pidef_atomic_add(&bn_verify_failures, 1);
+	fprintf(stderr, "Product of %lu limbs failed verification (attempt %d).\n", (unsigned long)r->size, attempt + 1);
+	if (attempt >= BN_VERIFY_RETRIES) {
+		fprintf(stderr, "Giving up, as the product is wrong every time.\n");
+		exit(EXIT_FAILURE);
+	}
+	return 0;
+}
+
+void bigint_mul(bigint *r, const bigint *a, const bigint *b) {
+	if (!a->size || !b->size) {
+		r->size = 0;
+		r->negative = 0;
+		return;
+	}
+
+	/* Residue of the result, if it is to be checked. */
+	const int verify = bigint_verify_wanted(a, b);
+	const uint64_t expected = verify ? bn_mulmod_prime(bigint_mod_verify(a), bigint_mod_verify(b), bn_verify_prime) : 0;
+
+	/* Multiply into a new array as the result may overlap an input. */
+	bigint prod;
+	bigint_init(&prod);
+	bigint_reserve(&prod, a->size + b->size);
+	for (int attempt = 0;; ++attempt) {
+		if (a->size >= b->size) bn_mul(prod.limbs, a->limbs, a->size, b->limbs, b->size);
+		else bn_mul(prod.limbs, b->limbs, b->size, a->limbs, a->size);
+		prod.size = a->size + b->size;
+		prod.negative = a->negative ^ b->negative;
+		bigint_normalize(&prod);
+		if (!verify || bigint_verify_result(&prod, expected, attempt)) break;
+	}
+
+	bigint_swap(r, &prod);
+	bigint_free(&prod);
+}
+
+void bigint_mul_sum(bigint *r, const bigint *a, const bigint *b, const bigint *c, const bigint *d) {
+	const size_t ab_min = a->size < b->size ? a->size : b->size, cd_min = c->size < d->size ? c->size : d->size;
+	const size_t ab_size = a->size + b->size, cd_size = c->size + d->size;
+	const size_t rn = (ab_size > cd_size ? ab_size : cd_size) + 1;
+
+	/* Small operands are multiplied separately. */
+	if (ab_min < BN_NTT_THRESHOLD || cd_min < BN_NTT_THRESHOLD || !bn_ntt_supported(rn)) {
+		bigint temp;
+		bigint_init(&temp);
+		bigint_mul(r, a, b);
+		bigint_mul(&temp, c, d);
+		bigint_add(r, r, &temp);
+		bigint_free(&temp);
+		return;
+	}
+
+	const int ab_negative = a->negative ^ b->negative, cd_negative = c->negative ^ d->negative;
+	const int verify = bigint_verify_wanted(a, b) || bigint_verify_wanted(c, d);
+	const uint64_t p = bn_verify_prime, expected = verify ? (bn_mulmod_prime(bigint_mod_verify(a), bigint_mod_verify(b), p)
+		+ bn_mulmod_prime(bigint_mod_verify(c), bigint_mod_verify(d), p)) % p : 0;
+
+	bigint_reserve(r, rn);
+	for (int attempt = 0;; ++attempt) {
+		r->negative = bn_mul_sum_ntt(r->limbs, rn, a->limbs, a->size, b->limbs, b->size,
+			c->limbs, c->size, d->limbs, d->size, ab_negative != cd_negative) ^ ab_negative;
+		r->size = rn;
+		bigint_normalize(r);
+		if (!verify || bigint_verify_result(r, expected, attempt)) break;
+	}
+}
+
+void bigint_mul_si(bigint *r, const bigint *a, long m) {
+	const size_t n = a->size;
+	const int negative = a->negative ^ (m < 0);
+	bigint_reserve(r, n + 1);
+	r->limbs[n] = bn_mul_1(r->limbs, a->limbs, n, (bn_limb)(m < 0 ? -m : m));
+	r->size = n + 1;
+	r->negative = negative;
+	bigint_normalize(r);
+}
+
+void bigint_divexact_si(bigint *r, const bigint *a, long d) {
+	const size_t n = a->size;
+	const int negative = a->negative ^ (d < 0);
+	bigint_reserve(r, n);
+	bn_divrem_1(r->limbs, a->limbs, n, (bn_limb)(d < 0 ? -d : d));
+	r->size = n;
+	r->negative = negative;
+	bigint_normalize(r);
+}
+
+void bigint_shl(bigint *r, const bigint *a, size_t bits) {
+	const size_t limbs = bits / BN_LIMB_BITS, n = a->size;
+	const int shift = (int)(bits % BN_LIMB_BITS);
+	if (!n) {
+		r->size = 0;
+		r->negative = 0;
+		return;
+	}
+
+	bigint_reserve(r, n + limbs + 1);
+	r->limbs[n + limbs] = shift ? a->limbs[n - 1] >> (BN_LIMB_BITS - shift) : 0;
+	for (size_t i = n - 1; i > 0; --i) {
+		r->limbs[i + limbs] = shift ? (a->limbs[i] << shift) | (a->limbs[i - 1] >> (BN_LIMB_BITS - shift)) : a->limbs[i];
+	}
+	r->limbs[limbs] = a->limbs[0] << shift;
+	memset(r->limbs, 0, limbs * sizeof *r->limbs);
+	r->size = n + limbs + 1;
+	r->negative = a->negative;
+	bigint_normalize(r);
+}
+
+void bigint_shr(bigint *r, const bigint *a, size_t bits) {
+	const size_t limbs = bits / BN_LIMB_BITS;
+	const int shift = (int)(bits % BN_LIMB_BITS);
+	if (a->size <= limbs) {
+		r->size = 0;
+		r->negative = 0;
+		return;
+	}
+
+	const size_t n = a->size - limbs;
+	const int negative = a->negative;
+	bigint_reserve(r, n);
+	for (size_t i = 0; i < n; ++i) {
+		const bn_limb high = i + 1 < n && shift ? a->limbs[i + limbs + 1] << (BN_LIMB_BITS - shift) : 0;
+		r->limbs[i] = (a->limbs[i + limbs] >> shift) | high;
+	}
+	r->size = n;
+	r->negative = negative;
+	bigint_normalize(r);
+}
+
+void bigint_div(bigint *q, const bigint *a, const bigint *d) {
+	if (a->size < d->size) {
+		q->size = 0;
+		q->negative = 0;
+		return;
+	}
+
+	const size_t qn = a->size - d->size + 1;
+	const int negative = a->negative ^ d->negative;
+	bn_limb *const quot = bn_alloc(qn);
+	bn_divrem(quot, NULL, a->limbs, a->size, d->limbs, d->size);
+	bigint_set_limbs(q, quot, qn);
+	q->negative = negative;
+	bigint_normalize(q);
+	bn_free(quot);
+}
+
+void bigint_pow_ui(bigint *r, bn_limb base, unsigned long exponent) {
+	bigint result, power;
+	bigint_init(&result);
+	bigint_init(&power);
+	bigint_set_ui(&result, 1);
+	bigint_set_ui(&power, base);
+
+	/* Exponentiation by squaring. */
+	for (; exponent; exponent >>= 1) {
+		if (exponent & 1) bigint_mul(&result, &result, &power);
+		if (exponent > 1) bigint_mul(&power, &power, &power);
+	}
+
+	bigint_swap(r, &result);
+	bigint_free(&result);
+	bigint_free(&power);
+}
+
+void bigint_sqrt(bigint *r, const bigint *a) {
+	bigint x, y;
+	bigint_init(&x);
+	bigint_init(&y);
+
+	/* Newton's method, starting from a power of two above the root and decreasing towards it. */
+	bigint_set_ui(&x, 1);
+	bigint_shl(&x, &x, (bigint_bit_length(a) + 1) / 2);
+	while (a->size) {
+		bigint_div(&y, a, &x);
+		bigint_add(&y, &y, &x);
+		bigint_shr(&y, &y, 1);
+		if (bigint_cmpabs(&y, &x) >= 0) break;
+		bigint_swap(&x, &y);
+	}
+	if (!a->size) x.size = 0;
+
+	bigint_swap(r, &x);
+	bigint_free(&x);
+	bigint_free(&y);
+}
+
+void bigint_mulhigh(bigint *r, const bigint *a, const bigint *b, size_t drop) {
+	if (a->size + b->size <= drop) {
+		r->size = 0;
+		r->negative = 0;
+		return;
+	}
+
+	bigint prod;
+	bigint_init(&prod);
+	bigint_reserve(&prod, a->size + b->size - drop);
+	prod.size = a->size + b->size - drop;
+	bn_mulhigh(prod.limbs, a->limbs, a->size, b->limbs, b->size, drop);
+	prod.negative = a->negative ^ b->negative;
+	bigint_normalize(&prod);
+
+	bigint_swap(r, &prod);
+	bigint_free(&prod);
+}
+
+/* Fills 'precs' with the precisions (in limbs) of each Newton step, from 'prec' down to the starting precision. */
+static int bigint_newton_precs(size_t *precs, size_t prec) {
+	int count = 0;
+	for (precs[count++] = prec; prec > 2; precs[count++] = prec) prec = prec / 2 + 1;
+	return count;
+}
+
+void bigint_recip(bigint *r, const bigint *d, size_t prec) {
+	/* Normalize so that the top bit is set, i.e. D = d / 2^(32 * dn) is in [1/2, 1). */
+	const size_t dn = d->size;
+	int shift = 0;
+	while (!(d->limbs[dn - 1] << shift & 0x80000000u)) ++shift;
+
+	/* One more limb is calculated so the normalization shift can be undone without losing accuracy. */
+	size_t precs[8 * sizeof(size_t)];
+	int step = bigint_newton_precs(precs, prec + 1) - 1;
+	const size_t max_prec = precs[0] > dn ? precs[0] : dn;
+
+	/* Top limbs of the normalized divisor, padded with zeros if it has fewer limbs than needed. */
+	bigint x, err, top;
+	bigint_init(&x);
+	bigint_init(&err);
+	bigint_init(&top);
+	bigint_shl(&top, d, shift);
+	bigint_reserve(&top, max_prec);
+	memmove(top.limbs + max_prec - dn, top.limbs, dn * sizeof *top.limbs);
+	memset(top.limbs, 0, (max_prec - dn) * sizeof *top.limbs);
+	const bn_limb *const top_end = top.limbs + max_prec;
+
+	/* Starting approximation X = floor(2^(64k) / (top k limbs)), which is 2^(32k) / D. */
+	size_t k = precs[step];
+	bn_limb *const numer = bn_alloc(2 * k + 1);
+	memset(numer, 0, 2 * k * sizeof *numer);
+	numer[2 * k] = 1;
+	bigint_reserve(&x, k + 2);
+	bn_divrem(x.limbs, NULL, numer, 2 * k + 1, top_end - k, k);
+	x.size = k + 2;
+	bigint_normalize(&x);
+	bn_free(numer);
+
+	while (step--) {
+		const size_t next = precs[step];
+
+		/* D * x is close to 1, so only the limbs representing its error e = 1 - Dx are needed (middle product). */
+		const size_t mid_n = next + 1 - k;
+		bigint_reserve(&err, mid_n);
+		bn_mulmid(err.limbs, top_end - next, next, x.limbs, x.size, k, next + 1);
+		err.size = mid_n;
+		err.negative = 0;
+		bigint_normalize(&err);
+
+		/* The kept limbs are -e modulo 2^(32 * mid_n); a small value means Dx is slightly above 1. */
+		if (err.size == mid_n && err.limbs[mid_n - 1] >> (BN_LIMB_BITS - 1)) {
+			for (size_t i = 0; i < mid_n; ++i) err.limbs[i] = ~err.limbs[i];
+			bn_add_1(err.limbs, err.limbs, mid_n, 1);
+		} else err.negative = err.size != 0;
+		bigint_normalize(&err);
+
+		/* x = x + x * e, where only the high half of x * e is needed (short product). */
+		bigint_mulhigh(&err, &x, &err, k);
+		bigint_shl(&x, &x, (next - k) * BN_LIMB_BITS);
+		bigint_add(&x, &x, &err);
+		k = next;
+	}
+
+	/* Undo the normalization: 1 / d = 2^shift / (d * 2^shift). */
+	bigint_shl(&x, &x, shift);
+	bigint_shr(r, &x, BN_LIMB_BITS);
+	bigint_free(&x);
+	bigint_free(&err);
+	bigint_free(&top);
+}
+
+void bigint_invsqrt_ui(bigint *r, bn_limb a, size_t prec) {
+	size_t precs[8 * sizeof(size_t)];
+	int step = bigint_newton_precs(precs, prec) - 1;
+
+	/* Starting approximation y = floor(sqrt(2^(128k) / a)) / 2^(32k), which is 2^(32k) / sqrt(a). */
+	size_t k = precs[step];
+	bigint y, err, one;
+	bigint_init(&y);
+	bigint_init(&err);
+	bigint_init(&one);
+	bigint_set_ui(&y, 1);
+	bigint_shl(&y, &y, 4 * k * BN_LIMB_BITS);
+	bn_divrem_1(y.limbs, y.limbs, y.size, a);
+	bigint_normalize(&y);
+	bigint_sqrt(&y, &y);
+	bigint_shr(&y, &y, k * BN_LIMB_BITS);
+
+	while (step--) {
+		const size_t next = precs[step], drop = 2 * k - next;
+
+		/* a * y^2 is close to 2^(64k). As 'a' is a single limb, the square is needed in full. */
+		bigint_mul(&err, &y, &y);
+		bigint_mul_si(&err, &err, (long)a);
+		bigint_shr(&err, &err, drop * BN_LIMB_BITS);
+
+		/* e = 1 - a * y^2, keeping only the limbs that affect the result. */
+		bigint_set_ui(&one, 1);
+		bigint_shl(&one, &one, next * BN_LIMB_BITS);
+		bigint_sub(&err, &one, &err);
+
+		/* y = y + y * e / 2, where only the high half of y * e is needed (short product). */
+		bigint_mulhigh(&err, &y, &err, k);
+		bigint_shr(&err, &err, 1);
+		bigint_shl(&y, &y, (next - k) * BN_LIMB_BITS);
+		bigint_add(&y, &y, &err);
+		k = next;
+	}
+
+	bigint_swap(r, &y);
+	bigint_free(&y);
+	bigint_free(&err);
+	bigint_free(&one);
+}
+
+/*
+   Writes the decimal digits of 'x' into 'out', returning how many were written. With 'pad', exactly 9 * 2^(k + 1) digits
+   are written (with leading zeros), otherwise no leading zeros (and nothing for 0). 'x' must be below 10^(9 * 2^(k + 1)).
+*/
+static size_t bigint_str_basecase(char *out, const bigint *x, int k, int pad) {
+	/* Extract 9 digits at a time from the least significant end, filling a buffer backwards. */
+	const size_t width = pad ? (size_t)9 << (k + 1) : x->size * 10;
+	char *const digits = (char*)malloc(width + 1);
+	bn_limb *const temp = bn_alloc(x->size ? x->size : 1);
+	if (!digits) {
+		fprintf(stderr, "Could not allocate memory for decimal string.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	char *pos = digits + width;
+	size_t n = x->size;
+	memcpy(temp, x->limbs, n * sizeof *temp);
+	while (n) {
+		bn_limb chunk = bn_divrem_1(temp, temp, n, 1000000000u);
+		n = bn_normalized_size(temp, n);
+		for (int i = 0; i < 9 && (n || chunk); ++i, chunk /= 10) *--pos = (char)('0' + chunk % 10);
+	}
+	if (pad) while (pos > digits) *--pos = '0';
+
+	const size_t written = (size_t)(digits + width - pos);
+	memcpy(out, pos, written);
+	bn_free(temp);
+	free(digits);
+	return written;
+}
+
+/*
+   Divide and conquer conversion: 'x' (below powers[k]^2) is split into x / powers[k] and x % powers[k], each converted with
+   the next smaller power. The quotient comes from a product with the reciprocal of the power, corrected by its remainder.
+*/
+static size_t bigint_str_split(char *out, const bigint *x, const bigint *powers, const bigint *recips, int k, int pad) {
+	if (k < 0 || x->size < BN_GET_STR_THRESHOLD) return bigint_str_basecase(out, x, k, pad);
+
+	/* Without padding, the leading zeros of a value below the power need no digits of their own. */
+	const bigint *const power = &powers[k];
+	if (!pad && bigint_cmpabs(x, power) < 0) return bigint_str_split(out, x, powers, recips, k - 1, 0);
+
+	bigint q, r, one;
+	bigint_init(&q);
+	bigint_init(&r);
+	bigint_init(&one);
+	bigint_set_ui(&one, 1);
+	bigint_mul(&q, x, &recips[k]);
+	bigint_shr(&q, &q, 2 * power->size * BN_LIMB_BITS);
+	bigint_mul(&r, &q, power);
+	bigint_sub(&r, x, &r);
+	while (r.negative) {
+		bigint_sub(&q, &q, &one);
+		bigint_add(&r, &r, power);
+	}
+	while (bigint_cmpabs(&r, power) >= 0) {
+		bigint_add(&q, &q, &one);
+		bigint_sub(&r, &r, power);
+	}
+
+	size_t written = bigint_str_split(out, &q, powers, recips, k - 1, pad);
+	bigint_free(&q);
+	written += bigint_str_split(out + written, &r, powers, recips, k - 1, 1);
+	bigint_free(&r);
+	bigint_free(&one);
+	return written;
+}
+
+char *bigint_get_str(const bigint *x) {
+	/* Each limb needs at most 10 decimal digits, with space for a sign and null terminator. */
+	const size_t max_chars = x->size * 10 + 2;
+	char *const str = (char*)malloc(max_chars);
+	if (!str) {
+		fprintf(stderr, "Could not allocate memory for decimal string.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/* Powers 10^(9 * 2^k) up to the first one whose square is above |x|, with their reciprocals for the split. */
+	bigint powers[8 * sizeof(size_t)], recips[8 * sizeof(size_t)];
+	int top = 0;
+	bigint_init(&powers[0]);
+	bigint_set_ui(&powers[0], 1000000000u);
+	while (x->size >= BN_GET_STR_THRESHOLD && 2 * powers[top].size < x->size + 2) {
+		bigint_init(&powers[top + 1]);
+		bigint_mul(&powers[top + 1], &powers[top], &powers[top]);
+		++top;
+	}
+	for (int k = 0; k <= top; ++k) {
+		bigint_init(&recips[k]);
+		if (powers[k].size >= BN_GET_STR_THRESHOLD / 2) bigint_recip(&recips[k], &powers[k], powers[k].size);
+	}
+
+	/* The magnitude is converted, with the sign added in front. */
+	char *pos = str;
+	if (x->negative) *pos++ = '-';
+	bigint magnitude = *x;
+	magnitude.negative = 0;
+	pos += bigint_str_split(pos, &magnitude, powers, recips, top, 0);
+	if (pos == str + x->negative) *pos++ = '0';
+	*pos = '\0';
+
+	for (int k = 0; k <= top; ++k) {
+		bigint_free(&powers[k]);
+		bigint_free(&recips[k]);
+	}
+	return str;
+}
+
+#endif
@@ -0,0 +1,782 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Generic binary splitting engine for hypergeometric series of the form
+
+       S = sum(a(k) * p(1)p(2)...p(k) / (q(1)q(2)...q(k)), k = 0..infinity)
+
+   where p, q and a are polynomials with integer coefficients. Splitting the terms [0, n) into two
+   halves and merging the results recursively turns the sum into a few very large multiplications,
+   which is far faster than summing the terms one by one. The top levels of the split tree are
+   calculated in separate threads.
+
+   Each series also has a 'finish' function that turns the final P, Q and T values into the constant,
+   such as pi = 426880 * sqrt(10005) * Q / T for the Chudnovsky series. Parts of the finish that do not
+   depend on the series (such as sqrt(10005)) are 'prepared' in their own thread while the series is
+   calculated, as the top merges of the split tree leave cores idle.
+
+   Near the root of the split tree, P, Q and T have far more limbs than the result needs, as only the ratio
+   of Q and T is used. Values longer than the target precision (plus guard limbs) can be truncated to their
+   most significant limbs, keeping the number of dropped limbs as an exponent, which makes the largest
+   multiplications smaller.
+
+   The P, Q and T values of the whole series can be saved as a checkpoint (written in the background
+   with c_asyncio.h) and loaded again, so the finishing steps can be repeated without the series.
+   A split stops early when cancelled (see pidef_cancel_signal in c_threads.h), keeping the largest completed
+   splits below the cancelled ones in 'bs_saved', which can be saved as a checkpoint as well. Splits loaded
+   from a checkpoint are used by the next bs_split of the same series and precision in place of calculating
+   them, so a cancelled series continues where it stopped. Checkpoints use the byte order of the machine that wrote them.
+
+   The progress of a split can be reported (see c_progress.h) by pointing 'bs_progress' at a started reporter.
+   Each leaf counts as one unit and each merge as the number of terms it covers, so every level of the tree
+   weighs the same, which follows the time taken more closely than counting nodes.
+
+   The series can also be calculated with decimal limbs (see c_decnum.h), so the result can be printed
+   without a radix conversion. Only the pi series has a decimal finish.
+
+   See https://en.wikipedia.org/wiki/Binary_splitting and
+   http://numbers.computation.free.fr/Constants/Algorithms/splitting.html for more information.
+*/
+
+#ifndef PI_C_BINSPLIT_H
+#define PI_C_BINSPLIT_H
+
+/* Required includes. */
+#include "c_bignum.h"
+#include "c_decnum.h"
+#include "c_threads.h"
+#include "c_asyncio.h"
+#include "c_progress.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+/* Extra limbs kept when truncating values to the target precision, covering the rounding of each merge. */
+#define BS_TRUNCATE_GUARD 4
+
+/* Highest supported polynomial degree. */
+#define BS_MAX_DEGREE 5
+
+/* Polynomial with integer coefficients, from the lowest degree to the highest. */
+typedef struct {
+	int degree;
+	int64_t coeffs[BS_MAX_DEGREE + 1];
+} bs_poly;
+
+/*
+   Values calculated by binary splitting for a range of terms [a, b). Truncated values are
+   P * 2^(32 * P_exp), Q * 2^(32 * Q_exp) and T * 2^(32 * T_exp); the exponents are 0 otherwise.
+*/
+typedef struct {
+	bigint P, Q, T;
+	size_t P_exp, Q_exp, T_exp;
+} bs_result;
+
+/* The same values with decimal limbs. */
+typedef struct { decint P, Q, T; } bs_dec_result;
+
+/* Description of a hypergeometric series and how to turn its sum into a constant. */
+typedef struct {
+	const char *name;
+	bs_poly p, q, a;
+
+	/* Optionally sets 'r' to a value needed by 'finish' that does not depend on the series. May be NULL. */
+	void (*prepare)(bigint *r, size_t prec);
+
+	/*
+	   Sets 'r' to the constant multiplied by 2^(32 * prec), given the (possibly truncated) results of
+	   all of the terms and the value from 'prepare' (if there is one).
+	*/
+	void (*finish)(bigint *r, const bs_result *res, const bigint *prepared, size_t prec);
+} bs_series;
+
+/*
+   Results of the split of the terms [a, b), kept after a cancelled split or loaded from a checkpoint. Splits are
+   only used by a bs_split of the same series and 'max_limbs', as splits running at the same time share the list.
+*/
+typedef struct {
+	const bs_series *series;
+	size_t max_limbs;
+	uint64_t a, b;
+	bs_result res;
+} bs_saved_split;
+
+/* Progress reporter updated by the splits, or NULL if progress is not reported. */
+pidef_progress *bs_progress;
+
+/* Saved splits, in no particular order. Splits are taken out of the list as bs_split uses them. */
+bs_saved_split *bs_saved;
+size_t bs_saved_count, bs_saved_capacity;
+
+/* A series' prepared value, calculated in its own thread. */
+typedef struct {
+	const bs_series *series;
+	size_t prec;
+	bigint value;
+	double seconds; /* Wall time taken to calculate the value. */
+	thread_id_t thread;
+} bs_prepare_task;
+
+
+/*
+   Function declarations.
+*/
+
+/* Sets 'r' to the given polynomial evaluated at 'k'. */
+void bs_poly_eval(bigint *r, const bs_poly *poly, uint64_t k);
+
+/* Returns the number of terms of the series needed for the given number of correct digits. */
+uint64_t bs_terms_needed(const bs_series *series, long digits);
+
+/*
+   Calculates the binary splitting values of the terms [a, b) of the given series into 'res',
+   which is initialized by this function. Splits of the top levels are calculated by up to 'threads' threads.
+   If 'max_limbs' is not 0, merged values with more limbs are truncated to their top 'max_limbs' limbs.
+   Any saved split of the same tree is used instead of being calculated.
+   Returns non-zero if the split completed, or 0 if it was cancelled, leaving 'res' empty and the completed
+   splits in 'bs_saved'.
+*/
+int bs_split(const bs_series *series, uint64_t a, uint64_t b, bs_result *res, int threads, size_t max_limbs);
+
+/* Returns the number of terms covered by the saved splits. */
+uint64_t bs_saved_terms(void);
+
+/* Frees all saved splits. */
+void bs_saved_free(void);
+
+/* Frees the integers in the given results. */
+void bs_result_free(bs_result *res);
+
+/* Returns the number of progress units of a split of 'terms' terms, for starting a reporter. */
+uint64_t bs_progress_total(uint64_t terms);
+
+/* Decimal limb versions of bs_poly_eval, bs_split and bs_result_free. */
+void bs_dec_poly_eval(decint *r, const bs_poly *poly, uint64_t k);
+void bs_dec_split(const bs_series *series, uint64_t a, uint64_t b, bs_dec_result *res, int threads);
+void bs_dec_result_free(bs_dec_result *res);
+
+/* Starts calculating the given series' prepared value for the given precision in a new thread, if it has one. */
+void bs_prepare_start(bs_prepare_task *task, const bs_series *series, size_t prec);
+
+/* Waits for the prepared value to be calculated. The value is freed with bigint_free. */
+void bs_prepare_join(bs_prepare_task *task);
+
+/*
+   Queues a checkpoint of the results of the first 'terms' terms of the built-in series with the given index.
+   The limbs are written directly from 'res', which must not be changed until the writer is closed.
+*/
+void bs_checkpoint_write(pidef_writer *writer, int series_index, uint64_t terms, const bs_result *res);
+
+/* Queues a checkpoint of the saved splits of a cancelled split of 'terms' terms, which must be kept until the writer is closed. */
+void bs_checkpoint_write_saved(pidef_writer *writer, int series_index, uint64_t terms);
+
+/*
+   Loads the splits in the given checkpoint into 'bs_saved', for the next bs_split of the first 'terms' terms of the
+   series with the given index with the given 'max_limbs'. Returns the number of terms they cover, or 0 if the file
+   could not be read or does not match.
+*/
+uint64_t bs_checkpoint_read(const char *path, int series_index, uint64_t terms, size_t max_limbs);
+
+/*
+   Sets 'r' to num / den multiplied by 2^(32 * prec), using a Newton reciprocal and a short product.
+   Truncated values are passed with 'prec' adjusted by the difference of their exponents.
+*/
+void bs_ratio(bigint *r, const bigint *num, const bigint *den, size_t prec);
+
+/* Sets 'r' to floor(x * 10^digits / 2^(32 * prec)), converting a fixed point result for printing. */
+void bs_fixed_to_decimal(bigint *r, const bigint *x, size_t prec, long digits);
+
+/*
+   Returns a malloc'd string of floor(x * 10^digits / 10^(9 * prec)) for a non-negative decimal fixed point result,
+   which only needs the extra digits to be cut off. 'digits' must be at most 9 * 'prec'.
+*/
+char *bs_dec_fixed_to_str(const decint *x, size_t prec, long digits);
+
+/* Prepare and finish functions of the built-in series. */
+void bs_prepare_pi(bigint *r, size_t prec);
+void bs_finish_pi(bigint *r, const bs_result *res, const bigint *prepared, size_t prec);
+void bs_finish_e(bigint *r, const bs_result *res, const bigint *prepared, size_t prec);
+void bs_finish_ln2(bigint *r, const bs_result *res, const bigint *prepared, size_t prec);
+void bs_finish_zeta3(bigint *r, const bs_result *res, const bigint *prepared, size_t prec);
+void bs_finish_catalan(bigint *r, const bs_result *res, const bigint *prepared, size_t prec);
+void bs_finish_sqrt2(bigint *r, const bs_result *res, const bigint *prepared, size_t prec);
+
+/* Sets 'r' to pi multiplied by 10^(9 * prec) from the decimal results of the pi series. */
+void bs_dec_finish_pi(decint *r, const bs_dec_result *res, size_t prec);
+
+
+/*
+   Built-in series.
+*/
+
+enum { BS_PI, BS_E, BS_LN2, BS_ZETA3, BS_CATALAN, BS_SQRT2, BS_SERIES_COUNT };
+
+static const bs_series bs_builtin_series[BS_SERIES_COUNT] = {
+	/* Chudnovsky: p(k) = -(6k - 5)(2k - 1)(6k - 1), q(k) = k^3 * 640320^3 / 24, a(k) = 13591409 + 545140134k */
+	{ "Pi (Chudnovsky)", { 3, { 5, -46, 108, -72 } }, { 3, { 0, 0, 0, INT64_C(10939058860032000) } },
+		{ 1, { 13591409, 545140134 } }, bs_prepare_pi, bs_finish_pi },
+
+	/* e = sum(1 / k!) */
+	{ "e", { 0, { 1 } }, { 1, { 0, 1 } }, { 0, { 1 } }, NULL, bs_finish_e },
+
+	/* ln(2) = 3/4 * sum((-1)^k (k!)^2 / (2^k (2k + 1)!)), p(k) = -k, q(k) = 8k + 4 */
+	{ "ln(2)", { 1, { 0, -1 } }, { 1, { 4, 8 } }, { 0, { 1 } }, NULL, bs_finish_ln2 },
+
+	/* Amdeberhan-Zeilberger: zeta(3) = 1/64 * sum((-1)^k (k!)^10 (205k^2 + 250k + 77) / ((2k + 1)!)^5) */
+	{ "Zeta(3) (Apery's constant)", { 5, { 0, 0, 0, 0, 0, -1 } }, { 5, { 32, 320, 1280, 2560, 2560, 1024 } },
+		{ 2, { 77, 250, 205 } }, NULL, bs_finish_zeta3 },
+
+	/* Catalan's constant = 1/2 * sum((-8)^k (3k + 2) / ((2k + 1)^3 binomial(2k, k)^3)) */
+	{ "Catalan's constant", { 3, { 0, 0, 0, -1 } }, { 3, { 1, 6, 12, 8 } }, { 1, { 2, 3 } }, NULL, bs_finish_catalan },
+
+	/* sqrt(2) = 7/5 * (1 - 1/50)^(-1/2) = 7/5 * sum(binomial(2k, k) / 200^k) */
+	{ "Square root of 2", { 1, { -1, 2 } }, { 1, { 0, 100 } }, { 0, { 1 } }, NULL, bs_finish_sqrt2 }
+};
+
+
+/*
+   Function definitions.
+*/
+
+void bs_poly_eval(bigint *r, const bs_poly *poly, uint64_t k) {
+	bigint coeff, x;
+	bigint_init(&coeff);
+	bigint_init(&x);
+	bigint_set_ui(&x, k);
+	bigint_set_ui(r, 0);
+
+	/* Horner's method. */
+	for (int i = poly->degree; i >= 0; --i) {
+		const int64_t c = poly->coeffs[i];
+		bigint_mul(r, r, &x);
+		bigint_set_ui(&coeff, c < 0 ? (uint64_t)-c : (uint64_t)c);
+		coeff.negative = c < 0 && coeff.size;
+		bigint_add(r, r, &coeff);
+	}
+
+	bigint_free(&coeff);
+	bigint_free(&x);
+}
+
+uint64_t bs_terms_needed(const bs_series *series, long digits) {
+	/* Sum the logarithms of each term's size until it is below the required precision. */
+	double log_term = 0.0;
+	const double log_first = log10(fabs((double)series->a.coeffs[0]) + 1.0);
+	uint64_t k = 1;
+
+	for (;; ++k) {
+		double p = 0.0, q = 0.0, a = 0.0;
+		for (int i = series->p.degree; i >= 0; --i) p = p * (double)k + (double)series->p.coeffs[i];
+		for (int i = series->q.degree; i >= 0; --i) q = q * (double)k + (double)series->q.coeffs[i];
+		for (int i = series->a.degree; i >= 0; --i) a = a * (double)k + (double)series->a.coeffs[i];
+		if (p == 0.0) break; /* All further terms are 0. */
+
+		log_term += log10(fabs(p)) - log10(fabs(q));
+		if (log_term + log10(fabs(a) + 1.0) < log_first - (double)digits - 2.0) break;
+	}
+
+	return k + 1;
+}
+
+/* Data for calculating a split in a separate thread. */
+typedef struct {
+	const bs_series *series;
+	uint64_t a, b;
+	bs_result *res;
+	int threads;
+	size_t max_limbs;
+	int use_saved, complete;
+} bs_thread_data;
+
+/* Protects the saved splits while threads take or add them. */
+static pidef_mutex_t bs_saved_lock = PIDEF_MUTEX_INIT;
+
+static int bs_split_node(const bs_series *series, uint64_t a, uint64_t b, bs_result *res, int threads, size_t max_limbs, int use_saved);
+
+/* Threading wrapper for bs_split_node. */
+static thread_func_t bs_split_thread(thread_arg_t data) {
+	bs_thread_data *const given = (bs_thread_data*)data;
+	given->complete = bs_split_node(given->series, given->a, given->b, given->res, given->threads, given->max_limbs, given->use_saved);
+	return 0;
+}
+
+/* Adds a completed split to the saved splits, which take over its values. */
+static void bs_saved_add(const bs_series *series, size_t max_limbs, uint64_t a, uint64_t b, const bs_result *res) {
+	pidef_mutex_lock(&bs_saved_lock);
+	if (bs_saved_count == bs_saved_capacity) {
+		bs_saved_capacity = bs_saved_capacity ? 2 * bs_saved_capacity : 16;
+		bs_saved = (bs_saved_split*)realloc(bs_saved, bs_saved_capacity * sizeof *bs_saved);
+		if (!bs_saved) {
+			fprintf(stderr, "Could not allocate memory for saved splits.\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	bs_saved[bs_saved_count].series = series;
+	bs_saved[bs_saved_count].max_limbs = max_limbs;
+	bs_saved[bs_saved_count].a = a;
+	bs_saved[bs_saved_count].b = b;
+	bs_saved[bs_saved_count++].res = *res;
+	pidef_mutex_unlock(&bs_saved_lock);
+}
+
+/*
+   Moves the saved split of [a, b) of the given series and 'max_limbs' into 'res' if there is one, returning non-zero
+   if so. Otherwise, sets 'inside' to whether any of its saved splits is within [a, b), as the splits below this one
+   only need to be checked if so.
+*/
+static int bs_saved_take(const bs_series *series, size_t max_limbs, uint64_t a, uint64_t b, bs_result *res, int *inside) {
+	int found = 0;
+	*inside = 0;
+
+	pidef_mutex_lock(&bs_saved_lock);
+	for (size_t i = 0; i < bs_saved_count; ++i) {
+		if (bs_saved[i].series != series || bs_saved[i].max_limbs != max_limbs) continue;
+		if (bs_saved[i].a == a && bs_saved[i].b == b) {
+			*res = bs_saved[i].res;
+			bs_saved[i] = bs_saved[--bs_saved_count];
+			found = 1;
+			break;
+		}
+		if (a <= bs_saved[i].a && bs_saved[i].b <= b) *inside = 1;
+	}
+	pidef_mutex_unlock(&bs_saved_lock);
+	return found;
+}
+
+/* Truncates 'x' to its top 'max_limbs' limbs, adding the number of dropped limbs to 'exp'. */
+static void bs_truncate(bigint *x, size_t *exp, size_t max_limbs) {
+	if (!max_limbs || x->size <= max_limbs) return;
+	const size_t drop = x->size - max_limbs;
+	bigint_shr(x, x, drop * BN_LIMB_BITS);
+	*exp += drop;
+}
+
+int bs_split(const bs_series *series, uint64_t a, uint64_t b, bs_result *res, int threads, size_t max_limbs) {
+	pidef_mutex_lock(&bs_saved_lock);
+	const int use_saved = bs_saved_count != 0;
+	pidef_mutex_unlock(&bs_saved_lock);
+	return bs_split_node(series, a, b, res, threads, max_limbs, use_saved);
+}
+
+/* Calculates a split, checking for saved splits within it if 'use_saved' is non-zero. */
+static int bs_split_node(const bs_series *series, uint64_t a, uint64_t b, bs_result *res, int threads, size_t max_limbs, int use_saved) {
+	if (use_saved && bs_saved_take(series, max_limbs, a, b, res, &use_saved)) {
+		if (bs_progress) pidef_progress_add(bs_progress, bs_progress_total(b - a));
+		return 1;
+	}
+
+	bigint_init(&res->P);
+	bigint_init(&res->Q);
+	bigint_init(&res->T);
+	res->P_exp = res->Q_exp = res->T_exp = 0;
+	if (pidef_cancel_signal) return 0;
+
+	if (b - a == 1) {
+		/* The first term is just a(0). */
+		if (!a) {
+			bigint_set_ui(&res->P, 1);
+			bigint_set_ui(&res->Q, 1);
+		} else {
+			bs_poly_eval(&res->P, &series->p, a);
+			bs_poly_eval(&res->Q, &series->q, a);
+		}
+
+		bs_poly_eval(&res->T, &series->a, a);
+		bigint_mul(&res->T, &res->T, &res->P);
+		pidef_progress_add(bs_progress, 1);
+		return 1;
+	}
+
+	const uint64_t m = (a + b) / 2;
+	bs_result am, mb;
+	int left_complete, right_complete;
+
+	/* Calculate the left half in a new thread and the right half in this one, splitting the threads between them. */
+	if (threads > 1) {
+		bs_thread_data left = { series, a, m, &am, threads / 2, max_limbs, use_saved, 0 };
+		thread_id_t left_thread;
+		pidef_create_thread(&left_thread, bs_split_thread, &left);
+		right_complete = bs_split_node(series, m, b, &mb, threads - threads / 2, max_limbs, use_saved);
+		pidef_join_thread(left_thread);
+		left_complete = left.complete;
+	} else {
+		left_complete = bs_split_node(series, a, m, &am, 1, max_limbs, use_saved);
+		right_complete = bs_split_node(series, m, b, &mb, 1, max_limbs, use_saved);
+	}
+
+	/* When cancelled, the completed halves are saved instead of merged, as the merges near the top take the longest. */
+	if (!left_complete || !right_complete || pidef_cancel_signal) {
+		if (left_complete) bs_saved_add(series, max_limbs, a, m, &am);
+		else bs_result_free(&am);
+		if (right_complete) bs_saved_add(series, max_limbs, m, b, &mb);
+		else bs_result_free(&mb);
+		return 0;
+	}
+
+	/* P = Pa * Pb, Q = Qa * Qb, T = Qb * Ta + Pa * Tb */
+	bigint_mul(&res->P, &am.P, &mb.P);
+	bigint_mul(&res->Q, &am.Q, &mb.Q);
+	res->P_exp = am.P_exp + mb.P_exp;
+	res->Q_exp = am.Q_exp + mb.Q_exp;
+
+	/* If the products of T have different exponents, a T operand of the lower one is truncated to match the other. */
+	const size_t left_exp = mb.Q_exp + am.T_exp, right_exp = am.P_exp + mb.T_exp;
+	if (left_exp < right_exp) bigint_shr(&am.T, &am.T, (right_exp - left_exp) * BN_LIMB_BITS);
+	if (right_exp < left_exp) bigint_shr(&mb.T, &mb.T, (left_exp - right_exp) * BN_LIMB_BITS);
+	bigint_mul_sum(&res->T, &mb.Q, &am.T, &am.P, &mb.T);
+	res->T_exp = left_exp > right_exp ? left_exp : right_exp;
+
+	bs_truncate(&res->P, &res->P_exp, max_limbs);
+	bs_truncate(&res->Q, &res->Q_exp, max_limbs);
+	bs_truncate(&res->T, &res->T_exp, max_limbs);
+
+	bs_result_free(&am);
+	bs_result_free(&mb);
+	pidef_progress_add(bs_progress, b - a);
+	return 1;
+}
+
+uint64_t bs_saved_terms(void) {
+	uint64_t terms = 0;
+	for (size_t i = 0; i < bs_saved_count; ++i) terms += bs_saved[i].b - bs_saved[i].a;
+	return terms;
+}
+
+void bs_saved_free(void) {
+	for (size_t i = 0; i < bs_saved_count; ++i) bs_result_free(&bs_saved[i].res);
+	free(bs_saved);
+	bs_saved = NULL;
+	bs_saved_count = bs_saved_capacity = 0;
+}
+
+void bs_result_free(bs_result *res) {
+	bigint_free(&res->P);
+	bigint_free(&res->Q);
+	bigint_free(&res->T);
+}
+
+uint64_t bs_progress_total(uint64_t terms) {
+	/* Each level of the tree only has splits of two neighbouring sizes, so count the splits of each size per level. */
+	uint64_t total = 0, size = terms, count = 1, next_count = 0;
+	while (size) {
+		/* 'count' splits of 'size' terms and 'next_count' of 'size' + 1. */
+		total += count * (size > 1 ? size : 1) + next_count * (size + 1);
+		if (size == 1) {
+			/* Splits of 2 terms have two leaves below them. */
+			total += next_count * 2;
+			break;
+		}
+
+		const uint64_t half = size / 2;
+		uint64_t small = 0, large = 0; /* Splits of 'half' and 'half' + 1 terms on the next level. */
+		if (size & 1) {
+			small += count;
+			large += count;
+		} else small += 2 * count;
+		if ((size + 1) & 1) {
+			small += next_count;
+			large += next_count;
+		} else large += 2 * next_count;
+
+		size = half;
+		count = small;
+		next_count = large;
+	}
+	return total;
+}
+
+void bs_dec_poly_eval(decint *r, const bs_poly *poly, uint64_t k) {
+	decint coeff, x;
+	decint_init(&coeff);
+	decint_init(&x);
+	decint_set_si(&x, (int64_t)k);
+	decint_set_si(r, 0);
+
+	/* Horner's method. */
+	for (int i = poly->degree; i >= 0; --i) {
+		decint_mul(r, r, &x);
+		decint_set_si(&coeff, poly->coeffs[i]);
+		decint_add(r, r, &coeff);
+	}
+
+	decint_free(&coeff);
+	decint_free(&x);
+}
+
+/* Data for calculating a decimal split in a separate thread. */
+typedef struct {
+	const bs_series *series;
+	uint64_t a, b;
+	bs_dec_result *res;
+	int threads;
+} bs_dec_thread_data;
+
+/* Threading wrapper for bs_dec_split. */
+static thread_func_t bs_dec_split_thread(thread_arg_t data) {
+	const bs_dec_thread_data *const given = (const bs_dec_thread_data*)data;
+	bs_dec_split(given->series, given->a, given->b, given->res, given->threads);
+	return 0;
+}
+
+void bs_dec_split(const bs_series *series, uint64_t a, uint64_t b, bs_dec_result *res, int threads) {
+	decint_init(&res->P);
+	decint_init(&res->Q);
+	decint_init(&res->T);
+
+	if (b - a == 1) {
+		if (!a) {
+			decint_set_si(&res->P, 1);
+			decint_set_si(&res->Q, 1);
+		} else {
+			bs_dec_poly_eval(&res->P, &series->p, a);
+			bs_dec_poly_eval(&res->Q, &series->q, a);
+		}
+
+		bs_dec_poly_eval(&res->T, &series->a, a);
+		decint_mul(&res->T, &res->T, &res->P);
+		pidef_progress_add(bs_progress, 1);
+		return;
+	}
+
+	const uint64_t m = (a + b) / 2;
+	bs_dec_result am, mb;
+
+	if (threads > 1) {
+		bs_dec_thread_data left = { series, a, m, &am, threads / 2 };
+		thread_id_t left_thread;
+		pidef_create_thread(&left_thread, bs_dec_split_thread, &left);
+		bs_dec_split(series, m, b, &mb, threads - threads / 2);
+		pidef_join_thread(left_thread);
+	} else {
+		bs_dec_split(series, a, m, &am, 1);
+		bs_dec_split(series, m, b, &mb, 1);
+	}
+
+	/* There is no fused sum of products for decimal limbs, so T = Qb * Ta + Pa * Tb uses two products. */
+	decint_mul(&res->P, &am.P, &mb.P);
+	decint_mul(&res->Q, &am.Q, &mb.Q);
+	decint_mul(&res->T, &mb.Q, &am.T);
+	decint_mul(&mb.T, &am.P, &mb.T);
+	decint_add(&res->T, &res->T, &mb.T);
+
+	bs_dec_result_free(&am);
+	bs_dec_result_free(&mb);
+	pidef_progress_add(bs_progress, b - a);
+}
+
+void bs_dec_result_free(bs_dec_result *res) {
+	decint_free(&res->P);
+	decint_free(&res->Q);
+	decint_free(&res->T);
+}
+
+/* Threading wrapper for a series' prepare function. */
+static thread_func_t bs_prepare_thread(thread_arg_t data) {
+	bs_prepare_task *const task = (bs_prepare_task*)data;
+	const double start = pidef_wall_seconds();
+	task->series->prepare(&task->value, task->prec);
+	task->seconds = pidef_wall_seconds() - start;
+	return 0;
+}
+
+void bs_prepare_start(bs_prepare_task *task, const bs_series *series, size_t prec) {
+	task->series = series;
+	task->prec = prec;
+	task->seconds = 0.0;
+	bigint_init(&task->value);
+	if (series->prepare) pidef_create_thread(&task->thread, bs_prepare_thread, task);
+}
+
+void bs_prepare_join(bs_prepare_task *task) {
+	if (task->series->prepare) pidef_join_thread(task->thread);
+}
+
+/* Identifies checkpoint files. */
+static const char bs_checkpoint_magic[8] = { 'P', 'I', 'B', 'S', 'C', 'H', 'K', '3' };
+
+/* Queues the header of a checkpoint of 'count' splits. */
+static void bs_checkpoint_write_header(pidef_writer *writer, int series_index, uint64_t terms, uint64_t count) {
+	const uint32_t index = (uint32_t)series_index;
+	pidef_writer_write(writer, bs_checkpoint_magic, sizeof bs_checkpoint_magic);
+	pidef_writer_write(writer, &index, sizeof index);
+	pidef_writer_write(writer, &terms, sizeof terms);
+	pidef_writer_write(writer, &count, sizeof count);
+}
+
+/* Queues the range of terms and the values of one split. */
+static void bs_checkpoint_write_split(pidef_writer *writer, uint64_t a, uint64_t b, const bs_result *res) {
+	pidef_writer_write(writer, &a, sizeof a);
+	pidef_writer_write(writer, &b, sizeof b);
+
+	/* Each integer is its sign, exponent, number of limbs and the limbs themselves. */
+	const bigint *const values[3] = { &res->P, &res->Q, &res->T };
+	const size_t exps[3] = { res->P_exp, res->Q_exp, res->T_exp };
+	for (int i = 0; i < 3; ++i) {
+		const uint32_t negative = (uint32_t)values[i]->negative;
+		const uint64_t exp = exps[i], size = values[i]->size;
+		pidef_writer_write(writer, &negative, sizeof negative);
+		pidef_writer_write(writer, &exp, sizeof exp);
+		pidef_writer_write(writer, &size, sizeof size);
+		pidef_writer_write_ref(writer, values[i]->limbs, values[i]->size * sizeof(bn_limb));
+	}
+}
+
+void bs_checkpoint_write(pidef_writer *writer, int series_index, uint64_t terms, const bs_result *res) {
+	bs_checkpoint_write_header(writer, series_index, terms, 1);
+	bs_checkpoint_write_split(writer, 0, terms, res);
+}
+
+void bs_checkpoint_write_saved(pidef_writer *writer, int series_index, uint64_t terms) {
+	bs_checkpoint_write_header(writer, series_index, terms, bs_saved_count);
+	for (size_t i = 0; i < bs_saved_count; ++i) bs_checkpoint_write_split(writer, bs_saved[i].a, bs_saved[i].b, &bs_saved[i].res);
+}
+
+/* Reads the values of one split, returning non-zero on success. 'res' is initialized by this function. */
+static int bs_checkpoint_read_split(FILE *file, bs_result *res) {
+	bigint_init(&res->P);
+	bigint_init(&res->Q);
+	bigint_init(&res->T);
+	res->P_exp = res->Q_exp = res->T_exp = 0;
+
+	bigint *const values[3] = { &res->P, &res->Q, &res->T };
+	size_t *const exps[3] = { &res->P_exp, &res->Q_exp, &res->T_exp };
+	for (int i = 0; i < 3; ++i) {
+		uint32_t negative;
+		uint64_t exp, size;
+		if (fread(&negative, sizeof negative, 1, file) != 1 || fread(&exp, sizeof exp, 1, file) != 1 ||
+			fread(&size, sizeof size, 1, file) != 1 || size > SIZE_MAX / sizeof(bn_limb)) return 0;
+
+		*exps[i] = (size_t)exp;
+
+		bigint_reserve(values[i], (size_t)size);
+		if (fread(values[i]->limbs, sizeof(bn_limb), (size_t)size, file) != (size_t)size) return 0;
+		values[i]->size = (size_t)size;
+		values[i]->negative = negative != 0;
+		bigint_normalize(values[i]);
+	}
+	return 1;
+}
+
+uint64_t bs_checkpoint_read(const char *path, int series_index, uint64_t terms, size_t max_limbs) {
+	FILE *const file = fopen(path, "rb");
+	if (!file) return 0;
+
+	char magic[sizeof bs_checkpoint_magic];
+	uint32_t index;
+	uint64_t file_terms, count;
+	int valid = fread(magic, sizeof magic, 1, file) == 1 && !memcmp(magic, bs_checkpoint_magic, sizeof magic) &&
+		fread(&index, sizeof index, 1, file) == 1 && index == (uint32_t)series_index &&
+		fread(&file_terms, sizeof file_terms, 1, file) == 1 && file_terms == terms &&
+		fread(&count, sizeof count, 1, file) == 1;
+
+	/* Splits outside of the series are rejected, but any other split that is not in the tree is never used. */
+	for (uint64_t i = 0; i < count && valid; ++i) {
+		uint64_t a, b;
+		bs_result res;
+		valid = fread(&a, sizeof a, 1, file) == 1 && fread(&b, sizeof b, 1, file) == 1 && a < b && b <= terms;
+		if (!valid) break;
+
+		valid = bs_checkpoint_read_split(file, &res);
+		if (valid) bs_saved_add(&bs_builtin_series[series_index], max_limbs, a, b, &res);
+		else bs_result_free(&res);
+	}
+
+	fclose(file);
+	if (!valid) bs_saved_free();
+	return valid ? bs_saved_terms() : 0;
+}
+
+void bs_ratio(bigint *r, const bigint *num, const bigint *den, size_t prec) {
+	bigint_recip(r, den, prec);
+	bigint_mulhigh(r, num, r, den->size);
+}
+
+void bs_fixed_to_decimal(bigint *r, const bigint *x, size_t prec, long digits) {
+	bigint scale;
+	bigint_init(&scale);
+	bigint_pow_ui(&scale, 10, (unsigned long)digits);
+	bigint_mul(r, x, &scale);
+	bigint_shr(r, r, prec * BN_LIMB_BITS);
+	bigint_free(&scale);
+}
+
+char *bs_dec_fixed_to_str(const decint *x, size_t prec, long digits) {
+	char *const str = decint_get_str(x);
+	const size_t length = strlen(str), drop = prec * DN_LIMB_DIGITS - (size_t)digits;
+
+	if (length > drop) str[length - drop] = '\0';
+	else strcpy(str, "0");
+	return str;
+}
+
+void bs_prepare_pi(bigint *r, size_t prec) {
+	/* sqrt(10005) = 10005 / sqrt(10005), as pi = 426880 * sqrt(10005) * Q / T. */
+	bigint_invsqrt_ui(r, 10005, prec);
+	bigint_mul_si(r, r, 10005);
+}
+
+void bs_finish_pi(bigint *r, const bs_result *res, const bigint *prepared, size_t prec) {
+	/* Q / T = (Q / T of the truncated values) * 2^(32 * (Q_exp - T_exp)), so the exponents only change the ratio's precision. */
+	bs_ratio(r, &res->Q, &res->T, prec + res->Q_exp - res->T_exp);
+	bigint_mulhigh(r, r, prepared, prec);
+	bigint_mul_si(r, r, 426880);
+}
+
+void bs_finish_e(bigint *r, const bs_result *res, const bigint *prepared, size_t prec) {
+	(void)prepared;
+	bs_ratio(r, &res->T, &res->Q, prec + res->T_exp - res->Q_exp);
+}
+
+void bs_finish_ln2(bigint *r, const bs_result *res, const bigint *prepared, size_t prec) {
+	(void)prepared;
+	bs_ratio(r, &res->T, &res->Q, prec + res->T_exp - res->Q_exp);
+	bigint_mul_si(r, r, 3);
+	bigint_shr(r, r, 2);
+}
+
+void bs_finish_zeta3(bigint *r, const bs_result *res, const bigint *prepared, size_t prec) {
+	(void)prepared;
+	bs_ratio(r, &res->T, &res->Q, prec + res->T_exp - res->Q_exp);
+	bigint_shr(r, r, 6);
+}
+
+void bs_finish_catalan(bigint *r, const bs_result *res, const bigint *prepared, size_t prec) {
+	(void)prepared;
+	bs_ratio(r, &res->T, &res->Q, prec + res->T_exp - res->Q_exp);
+	bigint_shr(r, r, 1);
+}
+
+void bs_finish_sqrt2(bigint *r, const bs_result *res, const bigint *prepared, size_t prec) {
+	(void)prepared;
+	bigint num, den;
+	bigint_init(&num);
+	bigint_init(&den);
+	bigint_mul_si(&num, &res->T, 7);
+	bigint_mul_si(&den, &res->Q, 5);
+	bs_ratio(r, &num, &den, prec + res->T_exp - res->Q_exp);
+	bigint_free(&num);
+	bigint_free(&den);
+}
+
+void bs_dec_finish_pi(decint *r, const bs_dec_result *res, size_t prec) {
+	/* sqrt(10005) = 10005 / sqrt(10005), as with the binary limbs. */
+	decint root;
+	decint_init(&root);
+	decint_invsqrt_ui(&root, 10005, prec);
+	decint_mul_si(&root, &root, 10005);
+
+	/* Q / T, shifting the limbs of T's reciprocal back out. */
+	decint_recip(r, &res->T, prec);
+	decint_mul(r, &res->Q, r);
+	decint_shr_limbs(r, r, res->T.size);
+
+	decint_mul(r, r, &root);
+	decint_shr_limbs(r, r, prec);
+	decint_mul_si(r, r, 426880);
+	decint_free(&root);
+}
+
+#endif
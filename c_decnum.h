@@ -0,0 +1,627 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Arbitrary precision integers stored in decimal, as an alternative to the binary 'bigint' values of
+   c_bignum.h for calculations whose result is printed in decimal.
+
+   Numbers are stored as arrays of 32-bit limbs holding digits in base 10^9, least significant limb first.
+   Converting a value to a string is then a simple formatting of each limb, instead of the radix
+   conversion needed for binary limbs, at the cost of slower arithmetic: each limb only holds ~29.9 bits,
+   carries need divisions by 10^9 (which compilers turn into multiplications) and fewer multiplication
+   tiers are implemented. Base 10^9 is used rather than 10^19 so that products of two limbs fit into
+   64 bits without needing 128-bit arithmetic.
+
+   The 'dn_' functions work on raw limb arrays and the 'decint_' functions work on signed, heap-allocated
+   'decint' values, matching the 'bn_' and 'bigint_' functions. Memory is allocated with the same
+   functions as binary limbs (including huge pages), and the number theoretic transforms of c_bignum.h
+   are reused for large products, splitting each limb into three 3-digit pieces.
+*/
+
+#ifndef PI_C_DECNUM_H
+#define PI_C_DECNUM_H
+
+/* Required includes. */
+#include "c_bignum.h"
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+/* Limbs have the same type as binary limbs, so the allocation, size and comparison functions are shared. */
+typedef bn_limb dn_limb;
+#define DN_BASE 1000000000u
+#define DN_LIMB_DIGITS 9
+
+/* Minimum operand sizes (in limbs) for each multiplication tier. */
+#define DN_KARATSUBA_THRESHOLD 32
+#define DN_NTT_THRESHOLD 4096
+
+/* Number of primes used by the decimal NTT. Products of 3-digit pieces are small enough for two. */
+#define DN_NTT_PRIMES 2
+
+/* Signed arbitrary precision integer in base 10^9. */
+typedef struct {
+	dn_limb *limbs; /* Magnitude, least significant limb first. */
+	size_t size, capacity; /* Used and allocated number of limbs. A size of 0 is the value 0. */
+	int negative; /* Non-zero if the value is negative. */
+} decint;
+
+
+/*
+   Raw limb array functions declarations.
+   These match the 'bn_' functions of the same name, but in base 10^9.
+*/
+
+/* r = a + b, for two arrays of size 'n'. Returns the carry. */
+dn_limb dn_add_n(dn_limb *r, const dn_limb *a, const dn_limb *b, size_t n);
+
+/* r = a + b, where 'an' >= 'bn'. 'r' has 'an' limbs and the carry is returned. */
+dn_limb dn_add(dn_limb *r, const dn_limb *a, size_t an, const dn_limb *b, size_t bn);
+
+/* r = a - b, for two arrays of size 'n'. Returns the borrow. */
+dn_limb dn_sub_n(dn_limb *r, const dn_limb *a, const dn_limb *b, size_t n);
+
+/* r = a - b, where 'an' >= 'bn'. 'r' has 'an' limbs and the borrow is returned. */
+dn_limb dn_sub(dn_limb *r, const dn_limb *a, size_t an, const dn_limb *b, size_t bn);
+
+/* r = a * m, where 'm' < 10^9, returning the most significant (carry) limb. */
+dn_limb dn_mul_1(dn_limb *r, const dn_limb *a, size_t n, dn_limb m);
+
+/* r += a * m, where 'm' < 10^9, returning the carry limb. 'r' must not overlap 'a'. */
+dn_limb dn_addmul_1(dn_limb *r, const dn_limb *a, size_t n, dn_limb m);
+
+/* q = a / d, returning the remainder. */
+dn_limb dn_divrem_1(dn_limb *q, const dn_limb *a, size_t n, dn_limb d);
+
+/*
+   Multiplication functions.
+   All of these write 'an' + 'bn' limbs into 'r', which must not overlap the inputs,
+   and require 'an' >= 'bn' >= 1 unless stated otherwise.
+*/
+
+/* Schoolbook multiplication, O(an * bn). */
+void dn_mul_basecase(dn_limb *r, const dn_limb *a, size_t an, const dn_limb *b, size_t bn);
+
+/* Karatsuba multiplication. Requires 'an' + 1 < 2 * 'bn'. */
+void dn_mul_karatsuba(dn_limb *r, const dn_limb *a, size_t an, const dn_limb *b, size_t bn);
+
+/* Multiplies 'b' by consecutive 'bn' sized pieces of 'a', accumulating the partial products. */
+void dn_mul_chunked(dn_limb *r, const dn_limb *a, size_t an, const dn_limb *b, size_t bn);
+
+/* Multiplication with number theoretic transforms of 3-digit pieces. Requires dn_ntt_supported('an' + 'bn'). */
+void dn_mul_ntt(dn_limb *r, const dn_limb *a, size_t an, const dn_limb *b, size_t bn);
+
+/* Returns non-zero if an 'rn' limb result can be calculated with number theoretic transforms. */
+int dn_ntt_supported(size_t rn);
+
+/* Chooses the best multiplication tier for the given operand sizes. */
+void dn_mul(dn_limb *r, const dn_limb *a, size_t an, const dn_limb *b, size_t bn);
+
+/* Same as dn_mul, but allows operands in any order, of any size and with most significant zero limbs. */
+void dn_mul_any(dn_limb *r, const dn_limb *a, size_t an, const dn_limb *b, size_t bn);
+
+
+/*
+   Decimal integer functions declarations.
+   Results may be the same object as any of the inputs.
+*/
+
+/* Initializes the given integer to 0. */
+void decint_init(decint *x);
+
+/* Frees the memory used by the given integer. */
+void decint_free(decint *x);
+
+/* Ensures the given integer can store at least 'n' limbs, keeping its value. */
+void decint_reserve(decint *x, size_t n);
+
+/* Removes most significant zero limbs and the sign of zero. */
+void decint_normalize(decint *x);
+
+/* Swaps the values of two integers. */
+void decint_swap(decint *a, decint *b);
+
+/* Sets 'x' to the given signed value. */
+void decint_set_si(decint *x, int64_t value);
+
+/* Compares the absolute values of 'a' and 'b', returning -1, 0 or 1. */
+int decint_cmpabs(const decint *a, const decint *b);
+
+/* r = a + b */
+void decint_add(decint *r, const decint *a, const decint *b);
+
+/* r = a - b */
+void decint_sub(decint *r, const decint *a, const decint *b);
+
+/* r = a * b */
+void decint_mul(decint *r, const decint *a, const decint *b);
+
+/* r = a * m, where |m| < 10^9. */
+void decint_mul_si(decint *r, const decint *a, long m);
+
+/* r = a / d, where 0 < d < 10^9, truncated towards zero. */
+void decint_div_ui(decint *r, const decint *a, dn_limb d);
+
+/* r = a * 10^(9 * limbs) */
+void decint_shl_limbs(decint *r, const decint *a, size_t limbs);
+
+/* r = a / 10^(9 * limbs), truncated towards zero. */
+void decint_shr_limbs(decint *r, const decint *a, size_t limbs);
+
+/*
+   Sets 'r' to an approximation of 10^(9 * ('d' limbs + 'prec')) / |d| within a few units in its last limb,
+   using Newton's iteration x = x + x(1 - dx). Two guard limbs are calculated, as a small most significant
+   limb of 'd' leaves its truncation to each step's precision with one limb less of relative accuracy.
+*/
+void decint_recip(decint *r, const decint *d, size_t prec);
+
+/*
+   Sets 'r' to an approximation of 10^(9 * 'prec') / sqrt(a) within a few units, using Newton's
+   iteration y = y + y(1 - ay^2) / 2.
+*/
+void decint_invsqrt_ui(decint *r, dn_limb a, size_t prec);
+
+/* Returns a malloc'd string of the decimal representation of 'x'. */
+char *decint_get_str(const decint *x);
+
+
+/*
+   Raw limb array functions definitions.
+*/
+
+dn_limb dn_add_n(dn_limb *r, const dn_limb *a, const dn_limb *b, size_t n) {
+	dn_limb carry = 0;
+	for (size_t i = 0; i < n; ++i) {
+		const dn_limb sum = a[i] + b[i] + carry; /* Below 2 * 10^9, so it cannot overflow. */
+		carry = sum >= DN_BASE;
+		r[i] = carry ? sum - DN_BASE : sum;
+	}
+	return carry;
+}
+
+dn_limb dn_add(dn_limb *r, const dn_limb *a, size_t an, const dn_limb *b, size_t bn) {
+	dn_limb carry = dn_add_n(r, a, b, bn);
+	for (size_t i = bn; i < an; ++i) {
+		const dn_limb sum = a[i] + carry;
+		carry = sum >= DN_BASE;
+		r[i] = carry ? sum - DN_BASE : sum;
+	}
+	return carry;
+}
+
+dn_limb dn_sub_n(dn_limb *r, const dn_limb *a, const dn_limb *b, size_t n) {
+	dn_limb borrow = 0;
+	for (size_t i = 0; i < n; ++i) {
+		const dn_limb sub = b[i] + borrow;
+		borrow = a[i] < sub;
+		r[i] = borrow ? a[i] + DN_BASE - sub : a[i] - sub;
+	}
+	return borrow;
+}
+
+dn_limb dn_sub(dn_limb *r, const dn_limb *a, size_t an, const dn_limb *b, size_t bn) {
+	dn_limb borrow = dn_sub_n(r, a, b, bn);
+	for (size_t i = bn; i < an; ++i) {
+		const dn_limb value = a[i];
+		r[i] = borrow && !value ? DN_BASE - 1 : value - borrow;
+		borrow = borrow && !value;
+	}
+	return borrow;
+}
+
+dn_limb dn_mul_1(dn_limb *r, const dn_limb *a, size_t n, dn_limb m) {
+	uint64_t carry = 0;
+	for (size_t i = 0; i < n; ++i) {
+		carry += (uint64_t)a[i] * m;
+		r[i] = (dn_limb)(carry % DN_BASE);
+		carry /= DN_BASE;
+	}
+	return (dn_limb)carry;
+}
+
+dn_limb dn_addmul_1(dn_limb *r, const dn_limb *a, size_t n, dn_limb m) {
+	uint64_t carry = 0;
+	for (size_t i = 0; i < n; ++i) {
+		carry += (uint64_t)a[i] * m + r[i]; /* Below 10^18 + 2 * 10^9, far from overflowing. */
+		r[i] = (dn_limb)(carry % DN_BASE);
+		carry /= DN_BASE;
+	}
+	return (dn_limb)carry;
+}
+
+dn_limb dn_divrem_1(dn_limb *q, const dn_limb *a, size_t n, dn_limb d) {
+	uint64_t rem = 0;
+	while (n--) {
+		const uint64_t cur = rem * DN_BASE + a[n];
+		q[n] = (dn_limb)(cur / d);
+		rem = cur % d;
+	}
+	return (dn_limb)rem;
+}
+
+void dn_mul_basecase(dn_limb *r, const dn_limb *a, size_t an, const dn_limb *b, size_t bn) {
+	r[an] = dn_mul_1(r, a, an, b[0]);
+	for (size_t i = 1; i < bn; ++i) r[an + i] = dn_addmul_1(r + i, a, an, b[i]);
+}
+
+void dn_mul_karatsuba(dn_limb *r, const dn_limb *a, size_t an, const dn_limb *b, size_t bn) {
+	/* Split both operands at 'h' limbs: a = a1 * X^h + a0 and b = b1 * X^h + b0. */
+	const size_t h = (an + 1) / 2, rn = an + bn;
+	const dn_limb *const a0 = a, *const a1 = a + h, *const b0 = b, *const b1 = b + h;
+
+	/* Low (a0 * b0) and high (a1 * b1) products are placed directly into the result. */
+	dn_mul_any(r, a0, h, b0, h);
+	dn_mul_any(r + 2 * h, a1, an - h, b1, bn - h);
+
+	/* Middle product: (a0 + a1)(b0 + b1) - a0 * b0 - a1 * b1 */
+	dn_limb *const sums = bn_alloc(4 * h + 4), *const sa = sums, *const sb = sums + h + 1, *const mid = sums + 2 * h + 2;
+	sa[h] = dn_add(sa, a0, h, a1, an - h);
+	sb[h] = dn_add(sb, b0, h, b1, bn - h);
+	dn_mul_any(mid, sa, h + 1, sb, h + 1);
+	dn_sub(mid, mid, 2 * h + 2, r, 2 * h);
+	dn_sub(mid, mid, 2 * h + 2, r + 2 * h, rn - 2 * h);
+
+	/* Add the middle product at its place. It is known to fit into the result's remaining limbs. */
+	dn_add(r + h, r + h, rn - h, mid, bn_normalized_size(mid, 2 * h + 2));
+	bn_free(sums);
+}
+
+void dn_mul_chunked(dn_limb *r, const dn_limb *a, size_t an, const dn_limb *b, size_t bn) {
+	dn_limb *const partial = bn_alloc(2 * bn);
+	memset(r, 0, (an + bn) * sizeof *r);
+
+	for (size_t offset = 0; offset < an; offset += bn) {
+		const size_t piece = an - offset < bn ? an - offset : bn;
+		dn_mul_any(partial, a + offset, piece, b, bn);
+		dn_add(r + offset, r + offset, an + bn - offset, partial, piece + bn);
+	}
+
+	bn_free(partial);
+}
+
+/* Splits the limbs into 3-digit pieces, padded with zeros to 'n' values, and applies the forward transform. */
+static void dn_ntt_load(uint32_t *t, const dn_limb *a, size_t an, size_t n, int prime, uint32_t *twiddles) {
+	for (size_t i = 0; i < an; ++i) {
+		t[3 * i] = a[i] % 1000u;
+		t[3 * i + 1] = a[i] / 1000u % 1000u;
+		t[3 * i + 2] = a[i] / 1000000u;
+	}
+	memset(t + 3 * an, 0, (n - 3 * an) * sizeof *t);
+	bn_ntt_forward(t, n, prime, twiddles);
+}
+
+int dn_ntt_supported(size_t rn) { return 3 * rn <= ((size_t)1 << BN_NTT_MAX_LOG2); }
+
+void dn_mul_ntt(dn_limb *r, const dn_limb *a, size_t an, const dn_limb *b, size_t bn) {
+	const size_t rn = an + bn;
+	size_t n = 1;
+	while (n < 3 * rn) n <<= 1;
+
+	/* Residues of the result for each prime, and scratch space for the other operand's transform. */
+	uint32_t *residues[DN_NTT_PRIMES];
+	for (int k = 0; k < DN_NTT_PRIMES; ++k) residues[k] = bn_ntt_scratch_get(n);
+	uint32_t *const twiddles = bn_ntt_scratch_get(n / 2), *const tb = bn_ntt_scratch_get(n);
+
+	for (int k = 0; k < DN_NTT_PRIMES; ++k) {
+		const uint32_t p = bn_ntt_primes[k];
+		uint32_t *const ta = residues[k];
+		dn_ntt_load(ta, a, an, n, k, twiddles);
+		dn_ntt_load(tb, b, bn, n, k, twiddles);
+		for (size_t i = 0; i < n; ++i) ta[i] = (uint32_t)((uint64_t)ta[i] * tb[i] % p);
+		bn_ntt_inverse(ta, n, k, twiddles);
+	}
+
+	/*
+	   Each piece of the product is at most 999^2 times the transform length (below 2^44), which is below the
+	   product of the two primes, so Garner's algorithm recovers it exactly and the carries fit into 64 bits.
+	*/
+	const uint64_t p1 = bn_ntt_primes[0], p2 = bn_ntt_primes[1];
+	const uint64_t p1_inv = bn_ntt_powmod((uint32_t)(p1 % p2), p2 - 2, (uint32_t)p2);
+	static const dn_limb scales[3] = { 1u, 1000u, 1000000u };
+
+	uint64_t carry = 0;
+	memset(r, 0, rn * sizeof *r);
+	for (size_t i = 0; i < 3 * rn; ++i) {
+		const uint64_t r1 = residues[0][i], r2 = residues[1][i];
+		carry += r1 + p1 * ((r2 + p2 - r1 % p2) % p2 * p1_inv % p2);
+		r[i / 3] += (dn_limb)(carry % 1000u) * scales[i % 3];
+		carry /= 1000u;
+	}
+
+	for (int k = 0; k < DN_NTT_PRIMES; ++k) bn_ntt_scratch_put(residues[k], n);
+	bn_ntt_scratch_put(twiddles, n / 2);
+	bn_ntt_scratch_put(tb, n);
+}
+
+void dn_mul(dn_limb *r, const dn_limb *a, size_t an, const dn_limb *b, size_t bn) {
+	if (bn < DN_KARATSUBA_THRESHOLD) dn_mul_basecase(r, a, an, b, bn);
+	else if (bn >= DN_NTT_THRESHOLD && dn_ntt_supported(an + bn)) dn_mul_ntt(r, a, an, b, bn);
+	else if (an + 1 < 2 * bn) dn_mul_karatsuba(r, a, an, b, bn);
+	else dn_mul_chunked(r, a, an, b, bn);
+}
+
+void dn_mul_any(dn_limb *r, const dn_limb *a, size_t an, const dn_limb *b, size_t bn) {
+	const size_t rn = an + bn;
+	an = bn_normalized_size(a, an);
+	bn = bn_normalized_size(b, bn);
+
+	if (!an || !bn) {
+		memset(r, 0, rn * sizeof *r);
+		return;
+	}
+
+	if (an >= bn) dn_mul(r, a, an, b, bn);
+	else dn_mul(r, b, bn, a, an);
+	memset(r + an + bn, 0, (rn - an - bn) * sizeof *r);
+}
+
+
+/*
+   Decimal integer functions definitions.
+*/
+
+void decint_init(decint *x) {
+	x->limbs = NULL;
+	x->size = x->capacity = 0;
+	x->negative = 0;
+}
+
+void decint_free(decint *x) {
+	bn_free(x->limbs);
+	decint_init(x);
+}
+
+void decint_reserve(decint *x, size_t n) {
+	if (n <= x->capacity) return;
+	dn_limb *const limbs = bn_alloc(n);
+	if (x->size) memcpy(limbs, x->limbs, x->size * sizeof *limbs);
+	bn_free(x->limbs);
+	x->limbs = limbs;
+	x->capacity = n;
+}
+
+void decint_normalize(decint *x) {
+	x->size = bn_normalized_size(x->limbs, x->size);
+	if (!x->size) x->negative = 0;
+}
+
+void decint_swap(decint *a, decint *b) {
+	const decint temp = *a;
+	*a = *b;
+	*b = temp;
+}
+
+void decint_set_si(decint *x, int64_t value) {
+	uint64_t magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+	decint_reserve(x, 3);
+	for (int i = 0; i < 3; ++i, magnitude /= DN_BASE) x->limbs[i] = (dn_limb)(magnitude % DN_BASE);
+	x->size = 3;
+	x->negative = value < 0;
+	decint_normalize(x);
+}
+
+int decint_cmpabs(const decint *a, const decint *b) {
+	if (a->size != b->size) return a->size > b->size ? 1 : -1;
+	return bn_cmp(a->limbs, b->limbs, a->size);
+}
+
+/* r = a + b, where 'b' is negated if 'b_negate' is set. */
+static void decint_addsub(decint *r, const decint *a, const decint *b, int b_negate) {
+	const int a_neg = a->negative, b_neg = b->negative ^ (b_negate && b->size);
+
+	if (a_neg == b_neg) {
+		/* Same signs: add magnitudes and keep the sign. */
+		const decint *const big = a->size >= b->size ? a : b, *const small = big == a ? b : a;
+		const size_t big_size = big->size, small_size = small->size;
+		decint_reserve(r, big_size + 1);
+		r->limbs[big_size] = dn_add(r->limbs, big->limbs, big_size, small->limbs, small_size);
+		r->size = big_size + 1;
+		r->negative = a_neg;
+	} else {
+		/* Different signs: subtract the smaller magnitude from the larger one. */
+		const int cmp = decint_cmpabs(a, b);
+		const decint *const big = cmp >= 0 ? a : b, *const small = big == a ? b : a;
+		const size_t big_size = big->size, small_size = small->size;
+		decint_reserve(r, big_size);
+		dn_sub(r->limbs, big->limbs, big_size, small->limbs, small_size);
+		r->size = big_size;
+		r->negative = cmp >= 0 ? a_neg : b_neg;
+	}
+
+	decint_normalize(r);
+}
+
+void decint_add(decint *r, const decint *a, const decint *b) { decint_addsub(r, a, b, 0); }
+
+void decint_sub(decint *r, const decint *a, const decint *b) { decint_addsub(r, a, b, 1); }
+
+void decint_mul(decint *r, const decint *a, const decint *b) {
+	if (!a->size || !b->size) {
+		r->size = 0;
+		r->negative = 0;
+		return;
+	}
+
+	/* Multiply into a new array as the result may overlap an input. */
+	decint prod;
+	decint_init(&prod);
+	decint_reserve(&prod, a->size + b->size);
+	if (a->size >= b->size) dn_mul(prod.limbs, a->limbs, a->size, b->limbs, b->size);
+	else dn_mul(prod.limbs, b->limbs, b->size, a->limbs, a->size);
+	prod.size = a->size + b->size;
+	prod.negative = a->negative ^ b->negative;
+	decint_normalize(&prod);
+
+	decint_swap(r, &prod);
+	decint_free(&prod);
+}
+
+void decint_mul_si(decint *r, const decint *a, long m) {
+	const size_t n = a->size;
+	const int negative = a->negative ^ (m < 0);
+	decint_reserve(r, n + 1);
+	r->limbs[n] = dn_mul_1(r->limbs, a->limbs, n, (dn_limb)(m < 0 ? -m : m));
+	r->size = n + 1;
+	r->negative = negative;
+	decint_normalize(r);
+}
+
+void decint_div_ui(decint *r, const decint *a, dn_limb d) {
+	const size_t n = a->size;
+	const int negative = a->negative;
+	decint_reserve(r, n);
+	dn_divrem_1(r->limbs, a->limbs, n, d);
+	r->size = n;
+	r->negative = negative;
+	decint_normalize(r);
+}
+
+void decint_shl_limbs(decint *r, const decint *a, size_t limbs) {
+	const size_t n = a->size;
+	if (!n) {
+		r->size = 0;
+		r->negative = 0;
+		return;
+	}
+
+	decint_reserve(r, n + limbs);
+	memmove(r->limbs + limbs, a->limbs, n * sizeof *r->limbs);
+	memset(r->limbs, 0, limbs * sizeof *r->limbs);
+	r->size = n + limbs;
+	r->negative = a->negative;
+}
+
+void decint_shr_limbs(decint *r, const decint *a, size_t limbs) {
+	if (a->size <= limbs) {
+		r->size = 0;
+		r->negative = 0;
+		return;
+	}
+
+	const size_t n = a->size - limbs;
+	decint_reserve(r, n);
+	memmove(r->limbs, a->limbs + limbs, n * sizeof *r->limbs);
+	r->size = n;
+	r->negative = a->negative;
+	decint_normalize(r);
+}
+
+/* Fills 'precs' with the precisions (in limbs) of each Newton step, from 'prec' down to the starting precision of 2. */
+static int decint_newton_precs(size_t *precs, size_t prec) {
+	int count = 0;
+	for (precs[count++] = prec; prec > 2; precs[count++] = prec) prec = prec / 2 + 1;
+	return count;
+}
+
+void decint_recip(decint *r, const decint *d, size_t prec) {
+	const size_t dn = d->size;
+	size_t precs[8 * sizeof(size_t)];
+	int step = decint_newton_precs(precs, prec + 2);
+
+	/*
+	   At each precision k, x is 10^(18k) / d_k, where d_k is 'd' scaled to k limbs. The starting approximation
+	   for k = 1 is calculated with doubles from the top limbs, accurate enough to go straight to k = 2.
+	*/
+	double top = 0.0, scale = 1.0;
+	for (size_t i = 0; i < 3 && i < dn; ++i, scale *= 1e-9) top += (double)d->limbs[dn - 1 - i] * scale;
+	precs[step] = 1;
+
+	decint x, dk, err;
+	decint_init(&x);
+	decint_init(&dk);
+	decint_init(&err);
+	decint_set_si(&x, (int64_t)(1e18 / top));
+
+	size_t k = 1;
+	while (step--) {
+		const size_t next = precs[step];
+		decint_shl_limbs(&x, &x, next - k);
+		if (dn >= next) decint_shr_limbs(&dk, d, dn - next);
+		else decint_shl_limbs(&dk, d, next - dn);
+		dk.negative = 0;
+
+		/* e = 10^(18 * next) - d_k * x, which is small as d_k * x is close to 10^(18 * next). */
+		decint_mul(&err, &dk, &x);
+		decint_set_si(&dk, 1);
+		decint_shl_limbs(&dk, &dk, 2 * next);
+		decint_sub(&err, &dk, &err);
+
+		/* x = x + x * e / 10^(18 * next) */
+		decint_mul(&err, &x, &err);
+		decint_shr_limbs(&err, &err, 2 * next);
+		decint_add(&x, &x, &err);
+		k = next;
+	}
+
+	/* x is 10^(9 * (k + 'd' limbs)) / d, with two more limbs than requested. */
+	decint_shr_limbs(r, &x, 2);
+	decint_free(&x);
+	decint_free(&dk);
+	decint_free(&err);
+}
+
+void decint_invsqrt_ui(decint *r, dn_limb a, size_t prec) {
+	size_t precs[8 * sizeof(size_t)];
+	int step = decint_newton_precs(precs, prec) - 1;
+
+	/* Starting approximation y = 10^18 / sqrt(a) for k = 2 (the smallest precision unless 'prec' is 1), accurate enough in a double. */
+	size_t k = precs[step];
+	decint y, err, one;
+	decint_init(&y);
+	decint_init(&err);
+	decint_init(&one);
+	decint_set_si(&y, (int64_t)(1e18 / sqrt((double)a)));
+	if (k < 2) decint_shr_limbs(&y, &y, 2 - k);
+
+	while (step--) {
+		const size_t next = precs[step];
+		decint_shl_limbs(&y, &y, next - k);
+
+		/* e = 10^(18 * next) - a * y^2 */
+		decint_mul(&err, &y, &y);
+		decint_mul_si(&err, &err, (long)a);
+		decint_set_si(&one, 1);
+		decint_shl_limbs(&one, &one, 2 * next);
+		decint_sub(&err, &one, &err);
+
+		/* y = y + y * e / 10^(18 * next) / 2 */
+		decint_mul(&err, &y, &err);
+		decint_shr_limbs(&err, &err, 2 * next);
+		decint_div_ui(&err, &err, 2);
+		decint_add(&y, &y, &err);
+		k = next;
+	}
+
+	decint_swap(r, &y);
+	decint_free(&y);
+	decint_free(&err);
+	decint_free(&one);
+}
+
+char *decint_get_str(const decint *x) {
+	/* Each limb is exactly 9 digits, except for the most significant one which has no leading zeros. */
+	const size_t max_chars = x->size * DN_LIMB_DIGITS + 3;
+	char *const str = (char*)malloc(max_chars);
+	if (!str) {
+		fprintf(stderr, "Could not allocate memory for decimal string.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	char *pos = str;
+	if (x->negative) *pos++ = '-';
+	if (!x->size) *pos++ = '0';
+	else pos += sprintf(pos, "%" PRIu32, x->limbs[x->size - 1]);
+
+	for (size_t i = x->size ? x->size - 1 : 0; i-- > 0;) {
+		dn_limb limb = x->limbs[i];
+		for (int j = DN_LIMB_DIGITS - 1; j >= 0; --j, limb /= 10) pos[j] = (char)('0' + limb % 10);
+		pos += DN_LIMB_DIGITS;
+	}
+
+	*pos = '\0';
+	return str;
+}
+
+#endif
@@ -0,0 +1,199 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Reference backend for the binary splitting engine using GMP (https://gmplib.org/) integers instead of
+   the arithmetic of c_bignum.h, so results and timings of the native engine can be compared with a mature library.
+
+   The split tree is the same as bs_split (including the threads at its top), without truncation, and the
+   pi series is finished exactly with integers: pi * 10^d = 426880 * isqrt(10005 * 10^2d) * Q / T.
+   GMP's own square root and division are used rather than Newton iterations, so a wrong product or
+   reciprocal in the native engine cannot produce the same wrong digits here.
+
+   This header is only usable when GMP is installed, which the build signals by defining PI_HAVE_GMP
+   and linking with the gmp library. Otherwise, including it defines nothing.
+*/
+
+#ifndef PI_C_GMPREF_H
+#define PI_C_GMPREF_H
+
+#ifdef PI_HAVE_GMP
+
+/* Required includes. */
+#include "c_binsplit.h"
+#include "c_threads.h"
+#include "c_memory.h"
+#include <gmp.h>
+#include <inttypes.h>
+#include <stdlib.h>
+
+/* Binary splitting values of a range of terms as GMP integers. */
+typedef struct { mpz_t P, Q, T; } bs_gmp_result;
+
+
+/*
+   Function declarations.
+*/
+
+/* Sets 'r' to the given 64-bit value, which may not fit into a long (such as on Windows). */
+void bs_gmp_set_i64(mpz_t r, int64_t value);
+
+/* GMP versions of bs_poly_eval, bs_split and bs_result_free. */
+void bs_gmp_poly_eval(mpz_t r, const bs_poly *poly, uint64_t k);
+void bs_gmp_split(const bs_series *series, uint64_t a, uint64_t b, bs_gmp_result *res, int threads);
+void bs_gmp_result_free(bs_gmp_result *res);
+
+/* Sets 'r' to floor(pi * 10^digits) from the results of the pi series. */
+void bs_gmp_finish_pi(mpz_t r, const bs_gmp_result *res, long digits);
+
+/* Makes GMP allocate through malloc while counting its allocations (see c_memory.h). Call before using GMP. */
+void bs_gmp_count_memory(void);
+
+
+/*
+   Function definitions.
+*/
+
+void bs_gmp_set_i64(mpz_t r, int64_t value) {
+	const uint64_t magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+	mpz_set_ui(r, (unsigned long)(magnitude >> 32));
+	mpz_mul_2exp(r, r, 32);
+	mpz_add_ui(r, r, (unsigned long)(magnitude & 0xFFFFFFFFu));
+	if (value < 0) mpz_neg(r, r);
+}
+
+void bs_gmp_poly_eval(mpz_t r, const bs_poly *poly, uint64_t k) {
+	mpz_t coeff, x;
+	mpz_init(coeff);
+	mpz_init(x);
+	bs_gmp_set_i64(x, (int64_t)k);
+	mpz_set_ui(r, 0);
+
+	/* Horner's method. */
+	for (int i = poly->degree; i >= 0; --i) {
+		mpz_mul(r, r, x);
+		bs_gmp_set_i64(coeff, poly->coeffs[i]);
+		mpz_add(r, r, coeff);
+	}
+
+	mpz_clear(coeff);
+	mpz_clear(x);
+}
+
+/* Data for calculating a GMP split in a separate thread. */
+typedef struct {
+	const bs_series *series;
+	uint64_t a, b;
+	bs_gmp_result *res;
+	int threads;
+} bs_gmp_thread_data;
+
+/* Threading wrapper for bs_gmp_split. */
+static thread_func_t bs_gmp_split_thread(thread_arg_t data) {
+	const bs_gmp_thread_data *const given = (const bs_gmp_thread_data*)data;
+	bs_gmp_split(given->series, given->a, given->b, given->res, given->threads);
+	return 0;
+}
+
+void bs_gmp_split(const bs_series *series, uint64_t a, uint64_t b, bs_gmp_result *res, int threads) {
+	mpz_init(res->P);
+	mpz_init(res->Q);
+	mpz_init(res->T);
+
+	if (b - a == 1) {
+		if (!a) {
+			mpz_set_ui(res->P, 1);
+			mpz_set_ui(res->Q, 1);
+		} else {
+			bs_gmp_poly_eval(res->P, &series->p, a);
+			bs_gmp_poly_eval(res->Q, &series->q, a);
+		}
+
+		bs_gmp_poly_eval(res->T, &series->a, a);
+		mpz_mul(res->T, res->T, res->P);
+		pidef_progress_add(bs_progress, 1);
+		return;
+	}
+
+	const uint64_t m = (a + b) / 2;
+	bs_gmp_result am, mb;
+
+	if (threads > 1) {
+		bs_gmp_thread_data left = { series, a, m, &am, threads / 2 };
+		thread_id_t left_thread;
+		pidef_create_thread(&left_thread, bs_gmp_split_thread, &left);
+		bs_gmp_split(series, m, b, &mb, threads - threads / 2);
+		pidef_join_thread(left_thread);
+	} else {
+		bs_gmp_split(series, a, m, &am, 1);
+		bs_gmp_split(series, m, b, &mb, 1);
+	}
+
+	/* P = Pa * Pb, Q = Qa * Qb, T = Qb * Ta + Pa * Tb */
+	mpz_mul(res->P, am.P, mb.P);
+	mpz_mul(res->Q, am.Q, mb.Q);
+	mpz_mul(res->T, mb.Q, am.T);
+	mpz_mul(mb.T, am.P, mb.T);
+	mpz_add(res->T, res->T, mb.T);
+
+	bs_gmp_result_free(&am);
+	bs_gmp_result_free(&mb);
+	pidef_progress_add(bs_progress, b - a);
+}
+
+void bs_gmp_result_free(bs_gmp_result *res) {
+	mpz_clear(res->P);
+	mpz_clear(res->Q);
+	mpz_clear(res->T);
+}
+
+void bs_gmp_finish_pi(mpz_t r, const bs_gmp_result *res, long digits) {
+	/* sqrt(10005) * 10^digits, rounded down. */
+	mpz_t root;
+	mpz_init(root);
+	mpz_ui_pow_ui(root, 10, 2 * (unsigned long)digits);
+	mpz_mul_ui(root, root, 10005);
+	mpz_sqrt(root, root);
+
+	mpz_mul(r, root, res->Q);
+	mpz_mul_ui(r, r, 426880);
+	mpz_tdiv_q(r, r, res->T);
+	mpz_clear(root);
+}
+
+/* GMP allocation functions counting their bytes, which GMP gives when reallocating and freeing as well. */
+static void *bs_gmp_alloc(size_t bytes) {
+	void *const ptr = malloc(bytes);
+	if (!ptr) {
+		fprintf(stderr, "Could not allocate %lu bytes of memory.\n", (unsigned long)bytes);
+		exit(EXIT_FAILURE);
+	}
+	if (pidef_memory_tracking) pidef_memory_count_alloc(bytes);
+	return ptr;
+}
+
+static void *bs_gmp_realloc(void *ptr, size_t old_bytes, size_t bytes) {
+	void *const resized = realloc(ptr, bytes);
+	if (!resized) {
+		fprintf(stderr, "Could not allocate %lu bytes of memory.\n", (unsigned long)bytes);
+		exit(EXIT_FAILURE);
+	}
+	if (pidef_memory_tracking) {
+		pidef_memory_count_free(old_bytes);
+		pidef_memory_count_alloc(bytes);
+	}
+	return resized;
+}
+
+static void bs_gmp_free(void *ptr, size_t bytes) {
+	if (pidef_memory_tracking) pidef_memory_count_free(bytes);
+	free(ptr);
+}
+
+void bs_gmp_count_memory(void) {
+	mp_set_memory_functions(bs_gmp_alloc, bs_gmp_realloc, bs_gmp_free);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,60 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   The Monte Carlo kernel used by pi_mcarlo and pi_batch: random points on a unit square, counted by whether
+   they lie inside the quadrant of the unit circle. The ratio of inside points to all points converges on pi/4.
+
+   The points can come from any generator of c_random.h. Each has its own copy of the loop, so the generator is
+   only chosen once per call and its inlined numbers cost the same as if it was the only one.
+
+   See https://en.wikipedia.org/wiki/Pi#Monte_Carlo_methods for more information.
+*/
+
+#ifndef PI_C_MCARLO_H
+#define PI_C_MCARLO_H
+
+/* Required includes. */
+#include "c_random.h"
+#include <inttypes.h>
+
+typedef uint_least64_t counter_t; /* Int type to store the number of 'points' during calculation. */
+
+
+/*
+   Function declarations.
+*/
+
+/* Generates the given number of points, adding to the counters of 'outside' and 'inside' points. */
+void generate_points(counter_t *counters, counter_t points, pidef_rng *rng);
+
+
+/*
+   Function definitions.
+*/
+
+/* Loop of generate_points, taking in an expression for the next random decimal. */
+#define MCARLO_POINTS_LOOP(next) \
+	for (counter_t i = 0; i < points; ++i) { \
+		/* Get a pseudo-random X and Y position, each in the range [0, 1]. */ \
+		const float randX = next, randY = next; \
+		/* The point is 'inside' the 'circle' if the coordinate sqr. length (X^2 + Y^2) is less than 1. \
+		   'Use conditional result (<1.0 = 1 else 0) for indexes into pointer. */ \
+		++counters[(randX * randX) + (randY * randY) < 1.0]; \
+	}
+
+void generate_points(counter_t *counters, counter_t points, pidef_rng *rng) {
+	/* The state is copied into a local for the loop, so it can stay in registers instead of possibly aliasing the counters. */
+	pidef_rng local = *rng;
+	switch (local.kind) {
+		case PIDEF_RNG_LCG: MCARLO_POINTS_LOOP(fastrand01(&local.state.lcg)) break;
+		case PIDEF_RNG_XORSHIFT: MCARLO_POINTS_LOOP(xorshift01(&local.state.x64)) break;
+		case PIDEF_RNG_XOSHIRO: MCARLO_POINTS_LOOP(xoshiro01(local.state.xoshiro)) break;
+		case PIDEF_RNG_PCG64: MCARLO_POINTS_LOOP(pcg01(&local.state.pcg)) break;
+		case PIDEF_RNG_SPLITMIX: MCARLO_POINTS_LOOP(splitmix01(&local.state.x64)) break;
+		case PIDEF_RNG_PHILOX: MCARLO_POINTS_LOOP(philox01(&local.state.philox)) break;
+	}
+	*rng = local;
+}
+
+#endif
@@ -0,0 +1,206 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Memory instrumentation for budgeting the memory of a calculation, reporting for each phase of a program
+   (such as the series, finish and conversion of pi_chudnovsky) the allocations made, the bytes they took,
+   the most bytes in use at once, and the peak resident set size (RSS) of the process.
+
+   Allocations are counted by the allocators that call pidef_memory_count_alloc and pidef_memory_count_free:
+   the big number allocator of c_bignum.h, GMP (see c_gmpref.h) and pidef_malloc. Counting only starts once
+   pidef_memory_start is called, so allocations cost nothing extra otherwise.
+
+   The peak RSS of each phase is read from /proc/self/status (VmHWM) on Linux, after resetting it at the start
+   of the phase through /proc/self/clear_refs. Where it cannot be reset, or on other POSIX OSs (with getrusage),
+   the peak is of the process so far, which is marked in the report.
+*/
+
+#ifndef PI_C_MEMORY_H
+#define PI_C_MEMORY_H
+
+/* Required includes. */
+#include "c_threads.h"
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef _MSC_VER
+#include <sys/resource.h>
+#endif
+
+/* Most phases reported by a program. */
+#define PIDEF_MEMORY_MAX_PHASES 8
+
+/* Bytes before each pidef_malloc allocation storing its size, keeping 16-byte alignment. */
+#define PIDEF_MALLOC_HEADER 16
+
+/* Memory used by one phase. */
+typedef struct {
+	const char *name;
+	uint64_t allocs, bytes; /* Allocations made in the phase, and their total bytes. */
+	uint64_t peak; /* Most bytes allocated at once in the phase, including those from earlier phases. */
+	long peak_rss_kb; /* Peak resident set size in KiB, or -1 if unavailable. */
+	int rss_of_phase; /* Non-zero if the peak RSS was reset at the start of the phase. */
+} pidef_memory_phase;
+
+/* Non-zero once pidef_memory_start is called, which allocators check before counting. */
+int pidef_memory_tracking;
+
+/* Allocation counters, and the phases so far. */
+uint64_t pidef_memory_allocs, pidef_memory_bytes, pidef_memory_live, pidef_memory_peak;
+static pidef_memory_phase pidef_memory_phases[PIDEF_MEMORY_MAX_PHASES];
+static int pidef_memory_phase_count, pidef_memory_phase_open, pidef_memory_rss_reset;
+
+
+/*
+   Function declarations.
+*/
+
+/*
+   Starts counting allocations, with the first phase called 'name'. Call it before allocating the memory to be
+   counted, as freeing memory allocated earlier would be subtracted from the bytes in use.
+*/
+void pidef_memory_start(const char *name);
+
+/* Ends the current phase and starts the next one called 'name', or only ends it if 'name' is NULL. */
+void pidef_memory_phase_next(const char *name);
+
+/* Ends the current phase and prints the memory used by each phase, if pidef_memory_start was called. */
+void pidef_memory_print(void);
+
+/* Counts an allocation or freeing of 'bytes' bytes. Allocators only call these while pidef_memory_tracking is set. */
+void pidef_memory_count_alloc(size_t bytes);
+void pidef_memory_count_free(size_t bytes);
+
+/* malloc and free, counted while tracking. Memory from pidef_malloc must be freed with pidef_free. */
+void *pidef_malloc(size_t bytes);
+void pidef_free(void *ptr);
+
+
+/*
+   Function definitions.
+*/
+
+void pidef_memory_count_alloc(size_t bytes) {
+	pidef_atomic_add(&pidef_memory_allocs, 1);
+	pidef_atomic_add(&pidef_memory_bytes, (uint64_t)bytes);
+	pidef_atomic_add(&pidef_memory_live, (uint64_t)bytes);
+	pidef_atomic_max(&pidef_memory_peak, pidef_atomic_load(&pidef_memory_live));
+}
+
+void pidef_memory_count_free(size_t bytes) {
+	pidef_atomic_add(&pidef_memory_live, (uint64_t)0 - (uint64_t)bytes);
+}
+
+void *pidef_malloc(size_t bytes) {
+	unsigned char *const block = (unsigned char*)malloc(bytes + PIDEF_MALLOC_HEADER);
+	if (!block) return NULL;
+	memcpy(block, &bytes, sizeof bytes);
+	if (pidef_memory_tracking) pidef_memory_count_alloc(bytes);
+	return block + PIDEF_MALLOC_HEADER;
+}
+
+void pidef_free(void *ptr) {
+	if (!ptr) return;
+	unsigned char *const block = (unsigned char*)ptr - PIDEF_MALLOC_HEADER;
+	size_t bytes;
+	memcpy(&bytes, block, sizeof bytes);
+	if (pidef_memory_tracking) pidef_memory_count_free(bytes);
+	free(block);
+}
+
+/* Resets the peak RSS of the process to its current RSS, returning non-zero on success. */
+static int pidef_memory_reset_rss(void) {
+	#ifdef __linux__
+	FILE *const file = fopen("/proc/self/clear_refs", "w");
+	if (!file) return 0;
+	const int written = fputs("5", file) >= 0;
+	return fclose(file) == 0 && written;
+	#else
+	return 0;
+	#endif
+}
+
+/* Returns the peak RSS of the process in KiB (since the last reset on Linux), or -1 if unavailable. */
+static long pidef_memory_peak_rss(void) {
+	#ifdef __linux__
+	FILE *const file = fopen("/proc/self/status", "r");
+	if (file) {
+		char line[256];
+		long kb = -1;
+		while (fgets(line, sizeof line, file)) if (!strncmp(line, "VmHWM:", 6)) kb = strtol(line + 6, NULL, 10);
+		fclose(file);
+		if (kb >= 0) return kb;
+	}
+	#endif
+
+	#ifdef _MSC_VER
+	return -1;
+	#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage)) return -1;
+	#ifdef __APPLE__
+	return (long)(usage.ru_maxrss / 1024); /* Bytes on macOS. */
+	#else
+	return (long)usage.ru_maxrss;
+	#endif
+	#endif
+}
+
+void pidef_memory_start(const char *name) {
+	pidef_memory_tracking = 1;
+	pidef_memory_phase_next(name);
+}
+
+void pidef_memory_phase_next(const char *name) {
+	if (!pidef_memory_tracking) return;
+
+	/* The counters of the current phase so far are turned into its totals. */
+	if (pidef_memory_phase_open) {
+		pidef_memory_phase *const phase = &pidef_memory_phases[pidef_memory_phase_count - 1];
+		phase->allocs = pidef_atomic_load(&pidef_memory_allocs) - phase->allocs;
+		phase->bytes = pidef_atomic_load(&pidef_memory_bytes) - phase->bytes;
+		phase->peak = pidef_atomic_load(&pidef_memory_peak);
+		phase->peak_rss_kb = pidef_memory_peak_rss();
+		phase->rss_of_phase = pidef_memory_rss_reset;
+		pidef_memory_phase_open = 0;
+	}
+	if (!name || pidef_memory_phase_count == PIDEF_MEMORY_MAX_PHASES) return;
+	pidef_memory_phase_open = 1;
+
+	pidef_memory_phase *const phase = &pidef_memory_phases[pidef_memory_phase_count++];
+	phase->name = name;
+	phase->allocs = pidef_atomic_load(&pidef_memory_allocs);
+	phase->bytes = pidef_atomic_load(&pidef_memory_bytes);
+	pidef_atomic_store(&pidef_memory_peak, pidef_atomic_load(&pidef_memory_live));
+	pidef_memory_rss_reset = pidef_memory_reset_rss();
+}
+
+/* Prints a number of bytes with a binary unit. */
+static void pidef_memory_print_bytes(double bytes) {
+	static const char *const units[] = { "B", "KiB", "MiB", "GiB", "TiB" };
+	int unit = 0;
+	for (; bytes >= 1024.0 && unit < 4; ++unit) bytes /= 1024.0;
+	printf(unit ? "%.1f %s" : "%.0f %s", bytes, units[unit]);
+}
+
+void pidef_memory_print(void) {
+	if (!pidef_memory_tracking) return;
+	pidef_memory_phase_next(NULL);
+
+	for (int i = 0; i < pidef_memory_phase_count; ++i) {
+		const pidef_memory_phase *const phase = &pidef_memory_phases[i];
+		printf("Memory (%s): %" PRIu64 " allocations of ", phase->name, phase->allocs);
+		pidef_memory_print_bytes((double)phase->bytes);
+		printf(", ");
+		pidef_memory_print_bytes((double)phase->peak);
+		printf(" peak in use, ");
+		if (phase->peak_rss_kb < 0) printf("peak RSS unavailable\n");
+		else {
+			pidef_memory_print_bytes((double)phase->peak_rss_kb * 1024.0);
+			printf(phase->rss_of_phase ? " peak RSS\n" : " peak RSS of the process so far\n");
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,135 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Progress reporting for long calculations, printing the percentage done, the rate and an
+   estimate of the remaining time to stderr while the calculation runs.
+
+   Workers add their completed units (such as split tree terms or Monte Carlo points) to a counter,
+   which a reporter thread sums and prints at a fixed interval. Each thread adds to its own cache line
+   sized slot, chosen once per thread, so workers never contend for a lock or a shared cache line and
+   an update is a single uncontended atomic add. Workers should still add in batches rather than per unit
+   in tight loops.
+*/
+
+#ifndef PI_C_PROGRESS_H
+#define PI_C_PROGRESS_H
+
+/* Required includes. */
+#include "c_threads.h"
+#include <inttypes.h>
+#include <string.h>
+#include <stdio.h>
+
+/* Number of counter slots. Threads beyond this share slots, which stays correct as additions are atomic. */
+#define PIDEF_PROGRESS_SLOTS 64
+
+/* Seconds between reports by default, and the longest the reporter sleeps before checking if it was stopped. */
+#define PIDEF_PROGRESS_INTERVAL 1.0
+#define PIDEF_PROGRESS_POLL 0.05
+
+/* A counter slot, padded to its own cache line. */
+typedef struct {
+	uint64_t count;
+	char padding[64 - sizeof(uint64_t)];
+} pidef_progress_slot;
+
+/* Progress of one calculation, reported by its own thread. */
+typedef struct {
+	pidef_progress_slot slots[PIDEF_PROGRESS_SLOTS];
+	const char *label, *unit; /* Printed before the report and after the rate, such as "Series" and "terms". */
+	uint64_t total; /* Number of units when the calculation is done. */
+	double interval, start_time;
+	volatile int running;
+	thread_id_t thread;
+} pidef_progress;
+
+/* Slot of the calling thread, plus one (0 until the thread first adds progress), and the next slot to hand out. */
+static PIDEF_THREAD_LOCAL int pidef_progress_thread_slot;
+static int pidef_progress_next_slot;
+
+
+/*
+   Function declarations.
+*/
+
+/*
+   Starts reporting the progress of a calculation of 'total' units every 'interval' seconds.
+   The progress must not be moved or freed until pidef_progress_stop returns.
+*/
+void pidef_progress_start(pidef_progress *progress, const char *label, const char *unit, uint64_t total, double interval);
+
+/* Adds 'n' completed units from the calling thread. Does nothing if 'progress' is NULL. */
+void pidef_progress_add(pidef_progress *progress, uint64_t n);
+
+/* Returns the number of completed units so far. */
+uint64_t pidef_progress_count(pidef_progress *progress);
+
+/* Stops the reporter thread, printing a final report. */
+void pidef_progress_stop(pidef_progress *progress);
+
+
+/*
+   Function definitions.
+*/
+
+/* Prints a single report over the previous one. */
+static void pidef_progress_print(pidef_progress *progress, int final) {
+	const uint64_t done = pidef_progress_count(progress);
+	const double elapsed = pidef_wall_seconds() - progress->start_time;
+	const double rate = elapsed > 0.0 ? (double)done / elapsed : 0.0;
+	const double fraction = progress->total ? (double)done / (double)progress->total : 1.0;
+
+	fprintf(stderr, "\r%s: %5.1f%% (%" PRIu64 "/%" PRIu64 " %s), %.3g %s/s", progress->label, fraction * 100.0,
+		done, progress->total, progress->unit, rate, progress->unit);
+	if (final) fprintf(stderr, ", %.1fs   \n", elapsed);
+	else if (rate > 0.0 && done < progress->total) fprintf(stderr, ", ETA %.0fs   ", (double)(progress->total - done) / rate);
+	else fprintf(stderr, ", ETA unknown   ");
+	fflush(stderr);
+}
+
+/* Reporter thread. */
+static thread_func_t pidef_progress_thread(thread_arg_t data) {
+	pidef_progress *const progress = (pidef_progress*)data;
+	double next_report = progress->start_time + progress->interval;
+
+	while (progress->running) {
+		pidef_sleep_seconds(PIDEF_PROGRESS_POLL);
+		if (progress->running && pidef_wall_seconds() >= next_report) {
+			pidef_progress_print(progress, 0);
+			next_report += progress->interval;
+		}
+	}
+	return 0;
+}
+
+void pidef_progress_start(pidef_progress *progress, const char *label, const char *unit, uint64_t total, double interval) {
+	memset(progress->slots, 0, sizeof progress->slots);
+	progress->label = label;
+	progress->unit = unit;
+	progress->total = total;
+	progress->interval = interval;
+	progress->start_time = pidef_wall_seconds();
+	progress->running = 1;
+	pidef_create_thread(&progress->thread, pidef_progress_thread, progress);
+}
+
+void pidef_progress_add(pidef_progress *progress, uint64_t n) {
+	if (!progress) return;
+	if (!pidef_progress_thread_slot) pidef_progress_thread_slot = pidef_atomic_inc_int(&pidef_progress_next_slot) % PIDEF_PROGRESS_SLOTS + 1;
+	pidef_atomic_add(&progress->slots[pidef_progress_thread_slot - 1].count, n);
+}
+
+uint64_t pidef_progress_count(pidef_progress *progress) {
+	uint64_t done = 0;
+	for (int i = 0; i < PIDEF_PROGRESS_SLOTS; ++i) done += pidef_atomic_load(&progress->slots[i].count);
+	return done;
+}
+
+void pidef_progress_stop(pidef_progress *progress) {
+	progress->running = 0;
+	pidef_join_thread(progress->thread);
+	pidef_progress_print(progress, 1);
+}
+
+#endif
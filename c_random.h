@@ -0,0 +1,321 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Pseudo-random number generators for the Monte Carlo programs, returning decimals in the range [0, 1].
+
+   fastrand01 is the original generator of pi_mcarlo: a multiplicative linear congruential generator
+   masked to RAND_MAX, which is fast but has weak low bits and a short period. xorshift01 (xorshift64*)
+   costs about the same and passes far more statistical tests, using the top bits of each output.
+
+   The other generators trade speed for quality in different ways: xoshiro256** and SplitMix64 are small
+   and fast 64-bit generators, PCG64 uses a 128-bit LCG with a permuted output, and Philox4x32-10 is
+   counter-based, so each seed (its key) gives an independent stream without any state to carry over.
+   All of them, the 64-bit ones filling a float's mantissa with their top 24 bits, are behind one interface
+   (pidef_rng) selected at run time by name, and pidef_rng_check runs a quick statistical sanity check of
+   the decimals they give. The check is meant to catch broken generators, not to replace test suites.
+
+   See https://en.wikipedia.org/wiki/Linear_congruential_generator,
+   https://en.wikipedia.org/wiki/Xorshift, https://prng.di.unimi.it/, https://www.pcg-random.org/ and
+   https://www.thesalmons.org/john/random123/papers/random123sc11.pdf for more information.
+*/
+
+#ifndef PI_C_RANDOM_H
+#define PI_C_RANDOM_H
+
+/* Required includes. */
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+/* Generators of pidef_rng, in the order of pidef_rng_names. */
+enum { PIDEF_RNG_LCG, PIDEF_RNG_XORSHIFT, PIDEF_RNG_XOSHIRO, PIDEF_RNG_PCG64, PIDEF_RNG_SPLITMIX, PIDEF_RNG_PHILOX, PIDEF_RNG_COUNT };
+static const char *const pidef_rng_names[PIDEF_RNG_COUNT] = { "lcg", "xorshift", "xoshiro", "pcg64", "splitmix", "philox" };
+
+/* State of a PCG64 generator: a 128-bit state and odd increment, as high and low halves. */
+typedef struct {
+	uint64_t state_hi, state_lo, inc_hi, inc_lo;
+} pidef_pcg64;
+
+/* State of a Philox4x32-10 generator: the counter of the next block, the key, and the unused words of the last block. */
+typedef struct {
+	uint32_t counter[4], key[2], block[4];
+	int used;
+} pidef_philox;
+
+/* A generator chosen at run time, with the state of each kind. */
+typedef struct {
+	int kind;
+	union {
+		unsigned lcg;
+		uint64_t x64; /* xorshift64* and SplitMix64. */
+		uint64_t xoshiro[4];
+		pidef_pcg64 pcg;
+		pidef_philox philox;
+	} state;
+} pidef_rng;
+
+/* Results of pidef_rng_check, each as a z-score: 0 for an ideal generator, with larger magnitudes less likely. */
+enum { PIDEF_RNG_TEST_UNIFORM, PIDEF_RNG_TEST_PAIRS, PIDEF_RNG_TEST_LOW_BITS, PIDEF_RNG_TEST_CORRELATION, PIDEF_RNG_TEST_PI, PIDEF_RNG_TESTS };
+static const char *const pidef_rng_test_names[PIDEF_RNG_TESTS] = { "uniform", "pairs", "low bits", "correlation", "pi" };
+
+/* Largest magnitude of a z-score that passes, which an ideal generator exceeds about once in 15,000 tests. */
+#define PIDEF_RNG_CHECK_LIMIT 4.0
+
+
+/*
+   Function declarations.
+*/
+
+/* Returns a 'pseudo-random' decimal in the range [0, 1] using the provided seed.
+   Modifies the seed for the next call. */
+float fastrand01(unsigned *seed);
+
+/* Returns a pseudo-random decimal in the range [0, 1) from a xorshift64* state, which must not be 0.
+   Modifies the state for the next call. */
+float xorshift01(uint64_t *state);
+
+/* Return the next 64 bits of a SplitMix64, xoshiro256**, PCG64 or Philox4x32-10 state (Philox giving 32 bits). */
+uint64_t splitmix64(uint64_t *state);
+uint64_t xoshiro256ss(uint64_t state[4]);
+uint64_t pcg64(pidef_pcg64 *state);
+uint32_t philox4x32(pidef_philox *state);
+
+/* Return a pseudo-random decimal in the range [0, 1) from each generator's state. */
+float splitmix01(uint64_t *state);
+float xoshiro01(uint64_t state[4]);
+float pcg01(pidef_pcg64 *state);
+float philox01(pidef_philox *state);
+
+/* Returns the generator with the given name, or -1 if there is none. */
+int pidef_rng_find(const char *name);
+
+/* Seeds a generator of the given kind. Any seed is valid, and different seeds give different streams. */
+void pidef_rng_seed(pidef_rng *rng, int kind, uint64_t seed);
+
+/* Returns a pseudo-random decimal in the range [0, 1) (or [0, 1] for the LCG) from a generator of any kind. */
+float pidef_rng01(pidef_rng *rng);
+
+/* Checks 'samples' decimals of a generator of the given kind, storing the z-score of each test into 'z'.
+   Returns the number of tests beyond PIDEF_RNG_CHECK_LIMIT. */
+int pidef_rng_check(int kind, uint64_t seed, uint64_t samples, double z[PIDEF_RNG_TESTS]);
+
+
+/*
+   Function definitions.
+*/
+
+float fastrand01(unsigned *seed) { return (float)( (*seed = 3812762923u * (*seed)) & RAND_MAX) / (float)RAND_MAX; }
+
+float xorshift01(uint64_t *state) {
+	uint64_t x = *state;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*state = x;
+
+	/* The top 24 bits fill a float's mantissa exactly. */
+	return (float)((x * UINT64_C(0x2545F4914F6CDD1D)) >> 40) * (1.0f / 16777216.0f);
+}
+
+uint64_t splitmix64(uint64_t *state) {
+	uint64_t z = (*state += UINT64_C(0x9E3779B97F4A7C15));
+	z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+	z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+	return z ^ (z >> 31);
+}
+
+uint64_t xoshiro256ss(uint64_t state[4]) {
+	const uint64_t x = state[1] * 5, result = ((x << 7) | (x >> 57)) * 9, t = state[1] << 17;
+	state[2] ^= state[0];
+	state[3] ^= state[1];
+	state[1] ^= state[2];
+	state[0] ^= state[3];
+	state[2] ^= t;
+	state[3] = (state[3] << 45) | (state[3] >> 19);
+	return result;
+}
+
+/* Returns the high 64 bits of the product of two 64-bit integers. */
+static uint64_t pidef_mulhi64(uint64_t a, uint64_t b) {
+	#ifdef __SIZEOF_INT128__
+	__extension__ typedef unsigned __int128 pidef_u128;
+	return (uint64_t)(((pidef_u128)a * b) >> 64);
+	#else
+	const uint64_t a_lo = a & 0xFFFFFFFFu, a_hi = a >> 32, b_lo = b & 0xFFFFFFFFu, b_hi = b >> 32;
+	const uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi;
+	const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFu) + lo_hi;
+	return a_hi * b_hi + (hi_lo >> 32) + (cross >> 32);
+	#endif
+}
+
+/* Advances a PCG64 state: state = state * multiplier + increment, modulo 2^128. */
+static void pidef_pcg64_step(pidef_pcg64 *state) {
+	static const uint64_t mul_hi = UINT64_C(0x2360ED051FC65DA4), mul_lo = UINT64_C(0x4385DF649FCCF645);
+	const uint64_t lo = state->state_lo * mul_lo;
+	const uint64_t hi = pidef_mulhi64(state->state_lo, mul_lo) + state->state_lo * mul_hi + state->state_hi * mul_lo;
+	state->state_lo = lo + state->inc_lo;
+	state->state_hi = hi + state->inc_hi + (state->state_lo < lo);
+}
+
+uint64_t pcg64(pidef_pcg64 *state) {
+	pidef_pcg64_step(state);
+
+	/* XSL RR output: the halves xored together, rotated by the top 6 bits. */
+	const uint64_t x = state->state_hi ^ state->state_lo;
+	const unsigned rot = (unsigned)(state->state_hi >> 58);
+	return (x >> rot) | (x << ((64 - rot) & 63));
+}
+
+uint32_t philox4x32(pidef_philox *state) {
+	if (state->used == 4) {
+		uint32_t c[4], k[2];
+		memcpy(c, state->counter, sizeof c);
+		memcpy(k, state->key, sizeof k);
+
+		/* Ten rounds of the Philox S-box: two 32x32-bit products mixed with the other words and the key. */
+		for (int round = 0; round < 10; ++round) {
+			const uint64_t p0 = (uint64_t)UINT32_C(0xD2511F53) * c[0], p1 = (uint64_t)UINT32_C(0xCD9E8D57) * c[2];
+			const uint32_t c1 = c[1], c3 = c[3];
+			c[0] = (uint32_t)(p1 >> 32) ^ c1 ^ k[0];
+			c[1] = (uint32_t)p1;
+			c[2] = (uint32_t)(p0 >> 32) ^ c3 ^ k[1];
+			c[3] = (uint32_t)p0;
+			k[0] += UINT32_C(0x9E3779B9);
+			k[1] += UINT32_C(0xBB67AE85);
+		}
+		memcpy(state->block, c, sizeof c);
+		state->used = 0;
+
+		/* The next block is of the next counter. */
+		for (int i = 0; i < 4 && !++state->counter[i]; ++i) {}
+	}
+	return state->block[state->used++];
+}
+
+/* The top 24 bits of each output fill a float's mantissa exactly. */
+float splitmix01(uint64_t *state) { return (float)(splitmix64(state) >> 40) * (1.0f / 16777216.0f); }
+float xoshiro01(uint64_t state[4]) { return (float)(xoshiro256ss(state) >> 40) * (1.0f / 16777216.0f); }
+float pcg01(pidef_pcg64 *state) { return (float)(pcg64(state) >> 40) * (1.0f / 16777216.0f); }
+float philox01(pidef_philox *state) { return (float)(philox4x32(state) >> 8) * (1.0f / 16777216.0f); }
+
+int pidef_rng_find(const char *name) {
+	for (int i = 0; i < PIDEF_RNG_COUNT; ++i) if (!strcmp(name, pidef_rng_names[i])) return i;
+	return -1;
+}
+
+void pidef_rng_seed(pidef_rng *rng, int kind, uint64_t seed) {
+	/* States that must not be all zero, or that should differ in more than a few bits for nearby seeds, are filled by SplitMix64. */
+	uint64_t mix = seed;
+	rng->kind = kind;
+	switch (kind) {
+		case PIDEF_RNG_LCG:
+			rng->state.lcg = (unsigned)seed;
+			break;
+		case PIDEF_RNG_XORSHIFT:
+			do rng->state.x64 = splitmix64(&mix); while (!rng->state.x64);
+			break;
+		case PIDEF_RNG_XOSHIRO:
+			for (int i = 0; i < 4; ++i) rng->state.xoshiro[i] = splitmix64(&mix);
+			break;
+		case PIDEF_RNG_PCG64: {
+			/* Seeded as pcg64_srandom_r, with the seed as the state and a stream of its own. */
+			pidef_pcg64 *const pcg = &rng->state.pcg;
+			const uint64_t stream = splitmix64(&mix);
+			pcg->state_hi = pcg->state_lo = 0;
+			pcg->inc_hi = stream >> 63;
+			pcg->inc_lo = (stream << 1) | 1;
+			pidef_pcg64_step(pcg);
+			pcg->state_lo += seed;
+			pcg->state_hi += pcg->state_lo < seed;
+			pidef_pcg64_step(pcg);
+			break;
+		}
+		case PIDEF_RNG_SPLITMIX:
+			rng->state.x64 = seed;
+			break;
+		case PIDEF_RNG_PHILOX:
+			/* The seed is the key, and each stream starts from counter 0. */
+			memset(&rng->state.philox, 0, sizeof rng->state.philox);
+			rng->state.philox.key[0] = (uint32_t)seed;
+			rng->state.philox.key[1] = (uint32_t)(seed >> 32);
+			rng->state.philox.used = 4;
+			break;
+	}
+}
+
+float pidef_rng01(pidef_rng *rng) {
+	switch (rng->kind) {
+		case PIDEF_RNG_LCG: return fastrand01(&rng->state.lcg);
+		case PIDEF_RNG_XORSHIFT: return xorshift01(&rng->state.x64);
+		case PIDEF_RNG_XOSHIRO: return xoshiro01(rng->state.xoshiro);
+		case PIDEF_RNG_PCG64: return pcg01(&rng->state.pcg);
+		case PIDEF_RNG_SPLITMIX: return splitmix01(&rng->state.x64);
+		default: return philox01(&rng->state.philox);
+	}
+}
+
+/* Returns the z-score of a chi-squared statistic with the given degrees of freedom, by the Wilson-Hilferty approximation. */
+static double pidef_rng_chi2_z(double chi2, double df) {
+	const double v = 2.0 / (9.0 * df);
+	return (cbrt(chi2 / df) - (1.0 - v)) / sqrt(v);
+}
+
+int pidef_rng_check(int kind, uint64_t seed, uint64_t samples, double z[PIDEF_RNG_TESTS]) {
+	/* Buckets of single decimals, of consecutive pairs (as the points of pi_mcarlo), and of consecutive pairs of their
+	   lowest 4 bits out of 24, which a generator with weak low bits repeats in a short cycle. */
+	enum { SINGLE_BINS = 64, PAIR_BINS = 32, LOW_BINS = 16 };
+	uint64_t *const counts = (uint64_t*)calloc(SINGLE_BINS + PAIR_BINS * PAIR_BINS + LOW_BINS * LOW_BINS, sizeof *counts);
+	if (!counts) return -1;
+	uint64_t *const single = counts, *const pairs = single + SINGLE_BINS, *const low = pairs + PAIR_BINS * PAIR_BINS;
+
+	pidef_rng rng;
+	pidef_rng_seed(&rng, kind, seed);
+	const uint64_t n = samples / 2;
+	double sum_xy = 0.0, sum = 0.0, sum_sq = 0.0, previous = 0.5;
+	uint64_t inside = 0;
+	for (uint64_t i = 0; i < n; ++i) {
+		const float x = pidef_rng01(&rng), y = pidef_rng01(&rng);
+		const int bx = x < 1.0f ? (int)(x * 16777216.0f) : 16777215, by = y < 1.0f ? (int)(y * 16777216.0f) : 16777215;
+		++single[bx >> 18];
+		++single[by >> 18];
+		++pairs[(bx >> 19) * PAIR_BINS + (by >> 19)];
+		++low[(bx & 15) * LOW_BINS + (by & 15)];
+		inside += x * x + y * y < 1.0f;
+
+		/* Consecutive decimals for the serial correlation, centred on the expected mean. */
+		sum_xy += (previous - 0.5) * (x - 0.5) + (x - 0.5) * (y - 0.5);
+		sum += x + y;
+		sum_sq += (x - 0.5) * (x - 0.5) + (y - 0.5) * (y - 0.5);
+		previous = y;
+	}
+
+	/* Chi-squared statistics of each set of buckets, against equally likely buckets. */
+	const double total = 2.0 * (double)n;
+	double chi2[3] = { 0.0, 0.0, 0.0 };
+	const uint64_t *const buckets[3] = { single, pairs, low };
+	const int bins[3] = { SINGLE_BINS, PAIR_BINS * PAIR_BINS, LOW_BINS * LOW_BINS };
+	const double observations[3] = { total, (double)n, (double)n };
+	for (int t = 0; t < 3; ++t) {
+		const double expected = observations[t] / bins[t];
+		for (int i = 0; i < bins[t]; ++i) chi2[t] += ((double)buckets[t][i] - expected) * ((double)buckets[t][i] - expected) / expected;
+		z[t] = pidef_rng_chi2_z(chi2[t], bins[t] - 1);
+	}
+	free(counts);
+
+	/* Lag-1 serial correlation, which is about normal with variance 1/n. */
+	const double mean = sum / total - 0.5;
+	const double covariance = sum_xy / total - mean * mean, variance = sum_sq / total - mean * mean;
+	z[PIDEF_RNG_TEST_CORRELATION] = variance > 0.0 ? covariance / variance * sqrt(total) : INFINITY;
+
+	/* Points inside the quadrant, which are binomial with a probability of pi/4. */
+	const double p = 3.14159265358979323846 / 4.0;
+	z[PIDEF_RNG_TEST_PI] = ((double)inside - (double)n * p) / sqrt((double)n * p * (1.0 - p));
+
+	int failed = 0;
+	for (int t = 0; t < PIDEF_RNG_TESTS; ++t) failed += !(fabs(z[t]) <= PIDEF_RNG_CHECK_LIMIT);
+	return failed;
+}
+
+#endif
@@ -0,0 +1,141 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Infinite series for pi used by pi_infseries and pi_batch. Each series continues from the state
+   left by its previous terms, so a calculation can be split into chunks of any number of terms.
+
+   See https://en.wikipedia.org/wiki/Pi#Infinite_series for more information.
+*/
+
+#ifndef PI_C_SERIES_H
+#define PI_C_SERIES_H
+
+/* Required includes. */
+#include <inttypes.h>
+#include <math.h>
+
+/* Types to use for storing calculations. */
+typedef uint64_t terms_t; /* Loops counter type. */
+typedef double pi_res_t; /* Calculation type. Preferably a floating point type. */
+
+/* Shortcut for do..while loop with 'terms' counter, which must be at least 1. */
+#define LOOP_TERMS(expr) do expr while(--terms)
+
+/* Running values of a series between chunks: the result so far and up to four other variables. */
+typedef struct {
+	pi_res_t res, v1, v2, v3, v4;
+} series_state;
+
+/* Number of series in series_function_data. */
+#define SERIES_COUNT 5
+
+
+/*
+   Function declarations.
+   All series take in the state left by the previous terms and the number of terms to add (loop count, at least 1).
+*/
+
+/* https://en.wikipedia.org/wiki/Wallis_product */
+void wallis_product(series_state *state, terms_t terms);
+
+/* https://en.wikipedia.org/wiki/Vi%C3%A8te%27s_formula */
+void vietes_formula(series_state *state, terms_t terms);
+
+/* https://en.wikipedia.org/wiki/Pi#cite_ref-FOOTNOTEArndtHaenel2006Formula_16.10,_p._223_78-0 */
+void nilakantha(series_state *state, terms_t terms);
+
+/* 
+   https://en.wikipedia.org/wiki/Arctangent_series
+   https://en.wikipedia.org/wiki/Leibniz_formula_for_%CF%80
+   Calculates 4 arctan(1). Newton's version converges much faster than this.
+   The generalized formula of this for any arctan x is known as the Gregory series.
+*/
+void madhava_leibniz_formula(series_state *state, terms_t terms);
+
+/* 
+   https://en.wikipedia.org/wiki/Pi#cite_ref-70
+   Infinite series to calculate 4 arctan(1).
+   Note that arctan 1 = pi/4.
+*/
+void newton_arctan_pi(series_state *state, terms_t terms);
+
+
+/*
+   Struct definitions.
+*/
+
+/* Storage of functions and name for printing, with the state before the first term and the multiplier of the result. */
+typedef struct {
+	void (*address)(series_state *state, terms_t terms);
+	const char *given_name;
+	series_state initial;
+	pi_res_t multiplier;
+} series_func_data;
+
+/* All calculation functions and names for display */
+static const series_func_data series_function_data[SERIES_COUNT] = {
+	{ wallis_product, "Wallis product", { 1.0, 0.0, 1.0, 0.0, 0.0 }, 2.0 },
+	{ vietes_formula, "Viete's formula", { 1.0, 0.0, 0.0, 0.0, 0.0 }, 2.0 },
+	{ nilakantha, "Nilakantha series", { 3.0, 2.0, -1.0, 0.0, 0.0 }, 1.0 },
+	{ madhava_leibniz_formula, "Madhava-Leibniz formula (arctan)", { 1.0, 1.0, 1.0, 0.0, 0.0 }, 4.0 },
+	{ newton_arctan_pi, "Newton series (arctan)", { 0.5, 0.0, 1.0, 1.0, 2.0 }, 4.0 }
+};
+
+
+/*
+   Function definitions.
+*/
+
+/* The running values are copied into locals for the loop, so they can stay in registers. */
+
+void wallis_product(series_state *state, terms_t terms) {
+	pi_res_t res = state->res, top = state->v1, bottom = state->v2;
+	LOOP_TERMS({
+		top += 2.0;
+		res *= (top / bottom);
+		bottom += 2.0;
+		res *= (top / bottom);
+	});
+	state->res = res;
+	state->v1 = top;
+	state->v2 = bottom;
+}
+
+void vietes_formula(series_state *state, terms_t terms) {
+	pi_res_t res = state->res, sqr_res = state->v1;
+	LOOP_TERMS( res *= 2.0 / (sqr_res = sqrt(2.0 + sqr_res)); );
+	state->res = res;
+	state->v1 = sqr_res;
+}
+
+void nilakantha(series_state *state, terms_t terms) {
+	pi_res_t res = state->res, denom_cnt = state->v1, sign = state->v2, denom = 0.0;
+	LOOP_TERMS({
+		denom = denom_cnt * (denom_cnt + 1.0);
+		res += (4.0 / (denom *= (denom_cnt += 2.0))) * (sign = -sign); 
+	});
+	state->res = res;
+	state->v1 = denom_cnt;
+	state->v2 = sign;
+}
+
+void madhava_leibniz_formula(series_state *state, terms_t terms) {
+	pi_res_t res = state->res, sign = state->v1, denom = state->v2;
+	LOOP_TERMS( res += (1.0 / (denom += 2.0)) * (sign = -sign); );
+	state->res = res;
+	state->v1 = sign;
+	state->v2 = denom;
+}
+
+void newton_arctan_pi(series_state *state, terms_t terms) {
+	pi_res_t res = state->res, fract_num = state->v1, fract_den = state->v2, fract_tot = state->v3, den_mult = state->v4;
+	LOOP_TERMS( res += (1.0 / (den_mult *= 2.0)) * (fract_tot *= ((fract_num += 2.0) / (fract_den += 2.0))); );
+	state->res = res;
+	state->v1 = fract_num;
+	state->v2 = fract_den;
+	state->v3 = fract_tot;
+	state->v4 = den_mult;
+}
+
+#endif
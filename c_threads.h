@@ -3,11 +3,28 @@
    under the MIT License (https://opensource.org/license/mit)
 
    Simple threading header to allow Windows OSs to run the C source files as it has its own threading interface.
-   Only implements portable thread creation and joining, which is needed  for the given multithreaded C programs.
+   Only implements portable thread creation and joining, which is needed  for the given multithreaded C programs,
+   a statically initialized mutex for shared caches, a sleep, and a wall clock timer, as clock() measures the
+   processor time of all threads on POSIX OSs.
+
+   Counters shared between threads are updated with the atomic operations below, which use compiler builtins
+   instead of the C11 headers. Relaxed ordering is enough for counters that are only read for reports.
+
+   Also handles cancellation: pidef_cancel_install makes SIGINT (Ctrl-C) and SIGTERM set pidef_cancel_signal,
+   which long calculations check between batches of work so they can stop with what they have calculated.
+   A second signal ends the program immediately, as it would without the handler.
 
    Thanks, Microsoft.
 */
 
+#ifndef PI_C_THREADS_H
+#define PI_C_THREADS_H
+
+/* Needed for clock_gettime when compiling as strict C99. */
+#if !defined(_MSC_VER) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
 #ifdef _MSC_VER
 /* Using Windows library */
 #define WIN32_LEAN_AND_MEAN
@@ -16,6 +33,8 @@
 #define thread_arg_t LPVOID
 #define thread_id_t HANDLE
 #define pi_i64 long long
+#define pidef_mutex_t SRWLOCK
+#define PIDEF_MUTEX_INIT SRWLOCK_INIT
 
 void pidef_create_thread(thread_id_t *thread_id, DWORD (*function)(thread_arg_t), thread_arg_t argument) {
 	*thread_id = CreateThread(NULL, 0, function, argument, 0, NULL);
@@ -24,13 +43,35 @@ void pidef_create_thread(thread_id_t *thread_id, DWORD (*function)(thread_arg_t)
 void pidef_join_thread(thread_id_t thread_id) {
 	WaitForSingleObject(thread_id, INFINITE);
 }
+
+void pidef_mutex_lock(pidef_mutex_t *mutex) {
+	AcquireSRWLockExclusive(mutex);
+}
+
+void pidef_mutex_unlock(pidef_mutex_t *mutex) {
+	ReleaseSRWLockExclusive(mutex);
+}
+
+double pidef_wall_seconds(void) {
+	LARGE_INTEGER count, frequency;
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&frequency);
+	return (double)count.QuadPart / (double)frequency.QuadPart;
+}
+
+void pidef_sleep_seconds(double seconds) {
+	Sleep((DWORD)(seconds * 1000.0));
+}
 #else
 /* Using POSIX threads */
 #include <pthread.h>
+#include <time.h>
 #define thread_func_t void *
 #define thread_arg_t void *
 #define thread_id_t pthread_t
 #define pi_i64 long
+#define pidef_mutex_t pthread_mutex_t
+#define PIDEF_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
 
 void pidef_create_thread(thread_id_t *thread_id, thread_func_t (*function)(thread_arg_t), thread_arg_t argument) {
 	pthread_create(thread_id, NULL, function, argument);
@@ -39,4 +80,84 @@ void pidef_create_thread(thread_id_t *thread_id, thread_func_t (*function)(threa
 void pidef_join_thread(thread_id_t thread_id) {
 	pthread_join(thread_id, NULL);
 }
+
+void pidef_mutex_lock(pidef_mutex_t *mutex) {
+	pthread_mutex_lock(mutex);
+}
+
+void pidef_mutex_unlock(pidef_mutex_t *mutex) {
+	pthread_mutex_unlock(mutex);
+}
+
+double pidef_wall_seconds(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+void pidef_sleep_seconds(double seconds) {
+	struct timespec duration;
+	duration.tv_sec = (time_t)seconds;
+	duration.tv_nsec = (long)((seconds - (double)duration.tv_sec) * 1e9);
+	nanosleep(&duration, NULL);
+}
+#endif
+
+/* Atomic operations on 64-bit counters, and incrementing an int (returning its previous value). */
+#include <inttypes.h>
+#ifdef _MSC_VER
+#define PIDEF_THREAD_LOCAL __declspec(thread)
+#define pidef_atomic_add(ptr, n) ((void)InterlockedExchangeAdd64((volatile LONG64*)(ptr), (LONG64)(n)))
+#define pidef_atomic_load(ptr) ((uint64_t)*(volatile LONG64*)(ptr))
+#define pidef_atomic_store(ptr, n) ((void)InterlockedExchange64((volatile LONG64*)(ptr), (LONG64)(n)))
+#define pidef_atomic_inc_int(ptr) (InterlockedIncrement((volatile LONG*)(ptr)) - 1)
+#define pidef_atomic_cas(ptr, old, n) (InterlockedCompareExchange64((volatile LONG64*)(ptr), (LONG64)(n), (LONG64)(old)) == (LONG64)(old))
+#else
+#define PIDEF_THREAD_LOCAL __thread
+#define pidef_atomic_add(ptr, n) ((void)__atomic_fetch_add((ptr), (n), __ATOMIC_RELAXED))
+#define pidef_atomic_load(ptr) __atomic_load_n((ptr), __ATOMIC_RELAXED)
+#define pidef_atomic_store(ptr, n) __atomic_store_n((ptr), (n), __ATOMIC_RELAXED)
+#define pidef_atomic_inc_int(ptr) __atomic_fetch_add((ptr), 1, __ATOMIC_RELAXED)
+#define pidef_atomic_cas(ptr, old, n) __sync_bool_compare_and_swap((ptr), (old), (n))
+#endif
+
+/* Raises the counter at 'ptr' to 'value' if it is lower. */
+void pidef_atomic_max(uint64_t *ptr, uint64_t value) {
+	uint64_t current = pidef_atomic_load(ptr);
+	while (value > current && !pidef_atomic_cas(ptr, current, value)) current = pidef_atomic_load(ptr);
+}
+
+/* Signal handling is part of standard C, with sigaction used where it is available. */
+#include <signal.h>
+#include <string.h>
+
+/* Number of the signal that requested cancellation, or 0 if there was none. */
+volatile sig_atomic_t pidef_cancel_signal;
+
+/* Sets pidef_cancel_signal on the first signal, and restores the default action for any later one. */
+static void pidef_cancel_handler(int sig) {
+	if (pidef_cancel_signal) {
+		signal(sig, SIG_DFL);
+		raise(sig);
+		return;
+	}
+	pidef_cancel_signal = sig;
+}
+
+/* Installs the cancellation handler for SIGINT and SIGTERM. */
+void pidef_cancel_install(void) {
+	#ifdef _MSC_VER
+	signal(SIGINT, pidef_cancel_handler);
+	signal(SIGTERM, pidef_cancel_handler);
+	#else
+	struct sigaction action;
+	memset(&action, 0, sizeof action);
+	action.sa_handler = pidef_cancel_handler;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = SA_RESTART;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	#endif
+}
+
 #endif
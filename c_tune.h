@@ -0,0 +1,324 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Thread count autotuner for programs whose threads run independent work, such as the Monte Carlo points
+   or the infinite series. The fastest number of threads depends on SMT (simultaneous multithreading, such as
+   Hyper-Threading), memory bandwidth and turbo clocks, so it is measured rather than assumed.
+
+   Thread counts are swept in two placements: 'cores', which pins each thread to a different physical core,
+   and 'smt', which fills all hardware threads of a core before using the next one. Each configuration runs
+   the program's work function on every thread for a number of units calibrated to take a short time, keeping
+   the best of a few runs, and the highest total rate wins. The choice is cached per host and program in
+   PIDEF_TUNE_CACHE (in the home directory), so later runs skip the sweep until a retune is asked for.
+
+   The processor topology is read from Linux's sysfs and threads are pinned with sched_setaffinity. On other OSs,
+   every logical processor counts as a core and threads are left where the OS schedules them.
+*/
+
+#ifndef PI_C_TUNE_H
+#define PI_C_TUNE_H
+
+/* Needed for sched_setaffinity when compiling as strict C99. Include this header before any system header. */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+/* Required includes. */
+#include "c_threads.h"
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+/* Most logical processors used, and the directory of their topology on Linux. */
+#define PIDEF_TUNE_MAX_CPUS 1024
+#ifndef PIDEF_CPU_SYSFS_PATH
+#define PIDEF_CPU_SYSFS_PATH "/sys/devices/system/cpu"
+#endif
+
+/* Seconds that one thread's work takes in each run, and the number of runs of each configuration. */
+#define PIDEF_TUNE_SECONDS 0.1
+#define PIDEF_TUNE_REPEATS 3
+
+/* Name of the cache of tuned configurations in the home directory. */
+#ifndef PIDEF_TUNE_CACHE
+#define PIDEF_TUNE_CACHE ".pi_autotune"
+#endif
+
+/* Placements of threads on the processors. */
+enum { PIDEF_PLACE_CORES, PIDEF_PLACE_SMT };
+static const char *const pidef_place_names[] = { "cores", "smt" };
+
+/* Logical processors usable by the process, in the order threads are pinned to them for each placement. */
+typedef struct {
+	int cpus, cores; /* Number of logical processors and of physical cores they belong to. */
+	int spread[PIDEF_TUNE_MAX_CPUS]; /* One processor of each core, then the other SMT siblings. */
+	int packed[PIDEF_TUNE_MAX_CPUS]; /* All processors of the first core, then of the second core, and so on. */
+} pidef_topology;
+
+/* A tuned configuration. */
+typedef struct {
+	int threads, placement;
+	double rate; /* Units per second of all threads together. */
+} pidef_tune_result;
+
+/* Work of one thread while tuning, which runs 'units' units of work (such as points or terms) as thread 'index'. */
+typedef void (*pidef_tune_work)(int index, uint64_t units);
+
+/* Topology of the processors, read by pidef_tune. */
+pidef_topology pidef_tune_topology;
+
+
+/*
+   Function declarations.
+*/
+
+/* Reads the logical processors usable by the process and the cores they belong to. */
+void pidef_topology_read(pidef_topology *topology);
+
+/*
+   Sets 'result' to the fastest configuration of at most 'max_threads' threads (or all processors if 0) for the
+   given work, printing the sweep. 'program' and 'unit' name the work in the cache and in the rates printed.
+   A configuration cached for this host is used instead of sweeping, unless 'retune' is non-zero.
+*/
+void pidef_tune(const char *program, const char *unit, pidef_tune_work work, int max_threads, int retune, pidef_tune_result *result);
+
+/* Pins the calling thread to the processor for thread 'index' of the tuned configuration. */
+void pidef_tune_pin(const pidef_tune_result *result, int index);
+
+
+/*
+   Function definitions.
+*/
+
+#ifdef __linux__
+/* Reads a single integer from a topology file of the given processor, returning 'fallback' if it cannot be read. */
+static long pidef_topology_value(int cpu, const char *name, long fallback) {
+	char path[256];
+	snprintf(path, sizeof path, "%s/cpu%d/topology/%s", PIDEF_CPU_SYSFS_PATH, cpu, name);
+	FILE *const file = fopen(path, "r");
+	if (!file) return fallback;
+	long value;
+	if (fscanf(file, "%ld", &value) != 1) value = fallback;
+	fclose(file);
+	return value;
+}
+#endif
+
+void pidef_topology_read(pidef_topology *topology) {
+	/* Each usable processor, and an identifier of its core that is unique across packages. */
+	int cpu_ids[PIDEF_TUNE_MAX_CPUS];
+	long core_keys[PIDEF_TUNE_MAX_CPUS];
+	topology->cpus = 0;
+
+	#ifdef __linux__
+	cpu_set_t allowed;
+	const int have_mask = !sched_getaffinity(0, sizeof allowed, &allowed);
+	for (int cpu = 0; cpu < PIDEF_TUNE_MAX_CPUS && cpu < CPU_SETSIZE; ++cpu) {
+		if (have_mask ? !CPU_ISSET(cpu, &allowed) : cpu >= sysconf(_SC_NPROCESSORS_ONLN)) continue;
+		cpu_ids[topology->cpus] = cpu;
+		core_keys[topology->cpus++] = (pidef_topology_value(cpu, "physical_package_id", 0) << 20) | pidef_topology_value(cpu, "core_id", cpu);
+	}
+	#else
+	#ifdef _MSC_VER
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	long count = (long)info.dwNumberOfProcessors;
+	#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	#endif
+	if (count > PIDEF_TUNE_MAX_CPUS) count = PIDEF_TUNE_MAX_CPUS;
+	for (int cpu = 0; cpu < count; ++cpu) {
+		cpu_ids[topology->cpus] = cpu;
+		core_keys[topology->cpus++] = cpu;
+	}
+	#endif
+
+	if (!topology->cpus) {
+		cpu_ids[0] = 0;
+		core_keys[0] = 0;
+		topology->cpus = 1;
+	}
+
+	/* The first processor seen of each core goes first in the spread order, and brings its siblings in the packed order. */
+	int spread_count = 0, packed_count = 0;
+	topology->cores = 0;
+	for (int i = 0; i < topology->cpus; ++i) {
+		int first = 1;
+		for (int j = 0; j < i && first; ++j) first = core_keys[j] != core_keys[i];
+		if (!first) continue;
+
+		++topology->cores;
+		topology->spread[spread_count++] = cpu_ids[i];
+		for (int j = i; j < topology->cpus; ++j) if (core_keys[j] == core_keys[i]) topology->packed[packed_count++] = cpu_ids[j];
+	}
+	for (int i = 0; i < topology->cpus; ++i) {
+		int first = 1;
+		for (int j = 0; j < i && first; ++j) first = core_keys[j] != core_keys[i];
+		if (!first) topology->spread[spread_count++] = cpu_ids[i];
+	}
+}
+
+/* Pins the calling thread to the given logical processor, if the OS allows it. */
+static void pidef_tune_pin_cpu(int cpu) {
+	#if defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	sched_setaffinity(0, sizeof set, &set);
+	#elif defined(_MSC_VER)
+	if (cpu < 64) SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu);
+	#else
+	(void)cpu;
+	#endif
+}
+
+void pidef_tune_pin(const pidef_tune_result *result, int index) {
+	const pidef_topology *const topology = &pidef_tune_topology;
+	const int *const order = result->placement == PIDEF_PLACE_SMT ? topology->packed : topology->spread;
+	pidef_tune_pin_cpu(order[index % topology->cpus]);
+}
+
+/* Data of one thread of a tuning run. */
+typedef struct {
+	pidef_tune_work work;
+	const pidef_tune_result *config;
+	int index;
+	uint64_t units;
+} pidef_tune_thread_data;
+
+/* Pins itself and runs the work of one thread of a tuning run. */
+static thread_func_t pidef_tune_thread(thread_arg_t data) {
+	const pidef_tune_thread_data *const given = (const pidef_tune_thread_data*)data;
+	pidef_tune_pin(given->config, given->index);
+	given->work(given->index, given->units);
+	return 0;
+}
+
+/* Runs 'units' units of work on each thread of the given configuration, returning the wall time taken. */
+static double pidef_tune_time(pidef_tune_work work, const pidef_tune_result *config, uint64_t units) {
+	pidef_tune_thread_data *const data = (pidef_tune_thread_data*)malloc(sizeof(pidef_tune_thread_data) * (size_t)config->threads);
+	thread_id_t *const threads = (thread_id_t*)malloc(sizeof(thread_id_t) * (size_t)config->threads);
+	if (!data || !threads) {
+		fprintf(stderr, "Could not allocate memory for autotuning.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	const double start_time = pidef_wall_seconds();
+	for (int i = 0; i < config->threads; ++i) {
+		data[i].work = work;
+		data[i].config = config;
+		data[i].index = i;
+		data[i].units = units;
+		pidef_create_thread(&threads[i], pidef_tune_thread, &data[i]);
+	}
+	for (int i = 0; i < config->threads; ++i) pidef_join_thread(threads[i]);
+	const double seconds = pidef_wall_seconds() - start_time;
+
+	free(threads);
+	free(data);
+	return seconds;
+}
+
+/* Writes the path of the cache file into 'path'. */
+static void pidef_tune_cache_path(char *path, size_t size) {
+	const char *home = getenv("HOME");
+	if (!home) home = getenv("USERPROFILE");
+	if (home) snprintf(path, size, "%s/%s", home, PIDEF_TUNE_CACHE);
+	else snprintf(path, size, "%s", PIDEF_TUNE_CACHE);
+}
+
+/* Writes the name of this host into 'name'. */
+static void pidef_tune_host(char *name, size_t size) {
+	#ifdef _MSC_VER
+	DWORD length = (DWORD)size;
+	if (!GetComputerNameA(name, &length)) snprintf(name, size, "unknown");
+	#else
+	if (gethostname(name, size)) snprintf(name, size, "unknown");
+	name[size - 1] = '\0';
+	#endif
+}
+
+void pidef_tune(const char *program, const char *unit, pidef_tune_work work, int max_threads, int retune, pidef_tune_result *result) {
+	pidef_topology *const topology = &pidef_tune_topology;
+	pidef_topology_read(topology);
+	if (max_threads <= 0 || max_threads > topology->cpus) max_threads = topology->cpus;
+
+	char path[4096], host[256];
+	pidef_tune_cache_path(path, sizeof path);
+	pidef_tune_host(host, sizeof host);
+
+	/* Each line of the cache is a configuration; the last one for this host, program and processors is used. */
+	if (!retune) {
+		FILE *const cache = fopen(path, "r");
+		int found = 0;
+		if (cache) {
+			char line_host[256], line_program[64], line_place[16];
+			int cpus, cores, threads, limit;
+			double rate;
+			while (fscanf(cache, "%255s %63s %d %d %d %d %15s %lf", line_host, line_program, &cpus, &cores, &limit,
+				&threads, line_place, &rate) == 8) {
+				if (strcmp(line_host, host) || strcmp(line_program, program) || cpus != topology->cpus ||
+					cores != topology->cores || limit != max_threads || threads < 1 || threads > max_threads) continue;
+				result->threads = threads;
+				result->placement = strcmp(line_place, pidef_place_names[PIDEF_PLACE_SMT]) ? PIDEF_PLACE_CORES : PIDEF_PLACE_SMT;
+				result->rate = rate;
+				found = 1;
+			}
+			fclose(cache);
+		}
+
+		if (found) {
+			printf("Autotune: %d thread(s) on %s from %s\n", result->threads, pidef_place_names[result->placement], path);
+			return;
+		}
+	}
+
+	printf("Autotune: %d logical processor(s) on %d core(s)\n", topology->cpus, topology->cores);
+
+	/* Calibrate the units of one thread to take about PIDEF_TUNE_SECONDS. */
+	pidef_tune_result config = { 1, PIDEF_PLACE_CORES, 0.0 };
+	uint64_t units = 1 << 12;
+	double seconds;
+	while ((seconds = pidef_tune_time(work, &config, units)) < PIDEF_TUNE_SECONDS / 4.0) units *= 4;
+	units = (uint64_t)((double)units * PIDEF_TUNE_SECONDS / seconds) + 1;
+
+	/* Sweep powers of two up to the cores and then up to all processors, as well as those counts themselves. */
+	result->rate = 0.0;
+	for (int placement = PIDEF_PLACE_CORES; placement <= PIDEF_PLACE_SMT; ++placement) {
+		const int limit = placement == PIDEF_PLACE_CORES ? (topology->cores < max_threads ? topology->cores : max_threads) : max_threads;
+		if (placement == PIDEF_PLACE_SMT && topology->cpus == topology->cores) break;
+
+		for (int threads = placement == PIDEF_PLACE_SMT ? 2 : 1; threads <= limit; threads = threads * 2 > limit && threads < limit ? limit : threads * 2) {
+			config.threads = threads;
+			config.placement = placement;
+			double best = 0.0;
+			for (int i = 0; i < PIDEF_TUNE_REPEATS; ++i) {
+				seconds = pidef_tune_time(work, &config, units);
+				if (!i || seconds < best) best = seconds;
+			}
+
+			config.rate = (double)units * (double)threads / best;
+			printf("Autotune: %d thread(s) on %s: %.4g %s/s\n", threads, pidef_place_names[placement], config.rate, unit);
+			if (config.rate > result->rate) *result = config;
+		}
+	}
+
+	FILE *const cache = fopen(path, "a");
+	if (cache) {
+		fprintf(cache, "%s %s %d %d %d %d %s %.6g\n", host, program, topology->cpus, topology->cores, max_threads,
+			result->threads, pidef_place_names[result->placement], result->rate);
+		fclose(cache);
+	}
+	printf("Autotune: chose %d thread(s) on %s%s%s\n", result->threads, pidef_place_names[result->placement],
+		cache ? ", saved to " : "", cache ? path : "");
+}
+
+#endif
@@ -0,0 +1,403 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Runs a manifest of many short calculations in one process, instead of starting a program (and its threads)
+   for each one. The jobs are shared by a pool of worker threads that lives for the whole manifest: each worker
+   takes the next job not yet taken by another, so long and short jobs balance out across the workers.
+
+   Each line of the manifest is one job, an engine followed by its parameters as key=value pairs:
+     mcarlo points=N [seed=S]        - Monte Carlo points (see pi_mcarlo), seeded with S (the job number by default)
+     series series=K terms=N         - terms of an infinite series (see pi_infseries), K being its number
+     constant constant=K digits=N    - digits of a constant (see pi_constants), K being its number
+   Blank lines and lines starting with '#' are ignored.
+
+   The result of each job is written as a line of JSON as soon as it finishes, so the lines are in the order the
+   jobs finished in rather than the manifest order. Each line has the job's number in the manifest ("job"), the
+   line it was on ("line"), its engine and parameters, the worker that ran it and its wall clock time, followed
+   by its results. Invalid jobs are written with an "error" instead, and do not stop the other jobs.
+
+   Ctrl-C or SIGTERM stops the workers from taking new jobs. Monte Carlo and series jobs already running are
+   finished, while constant jobs still in their series stop it early and are written with a "cancelled" error.
+*/
+
+/* Required includes. */
+#include "c_tune.h"
+#include "c_series.h"
+#include "c_mcarlo.h"
+#include "c_binsplit.h"
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/* Number of extra digits calculated to avoid rounding errors in the last digits of constants. */
+#define GUARD_DIGITS 10
+
+/* Longest manifest line. */
+#define MAX_LINE_LENGTH 1024
+
+/* Most worker threads, beyond which more would only add overhead. */
+#define MAX_WORKERS 1024
+
+/* Engines a job can run, and the parameters of each. */
+enum { JOB_MCARLO, JOB_SERIES, JOB_CONSTANT, JOB_ENGINE_COUNT };
+#define JOB_MAX_PARAMS 2
+
+typedef struct {
+	const char *name;
+	const char *params[JOB_MAX_PARAMS];
+	uint64_t min[JOB_MAX_PARAMS], max[JOB_MAX_PARAMS]; /* Range of each parameter. */
+} job_engine;
+
+static const job_engine job_engines[JOB_ENGINE_COUNT] = {
+	{ "mcarlo", { "points", "seed" }, { 1, 1 }, { UINT64_MAX, UINT32_MAX } },
+	{ "series", { "series", "terms" }, { 1, 1 }, { SERIES_COUNT, UINT64_MAX } },
+	{ "constant", { "constant", "digits" }, { 1, 1 }, { BS_SERIES_COUNT, 100000000 } }
+};
+
+/* A job of the manifest. */
+typedef struct {
+	int line, engine;
+	uint64_t params[JOB_MAX_PARAMS];
+	const char *error; /* Why the job is invalid, or NULL. */
+} batch_job;
+
+/* Jobs of the manifest, the index of the next one for a worker to take, and the number that failed. */
+static batch_job *jobs;
+static int job_count, next_job, jobs_failed;
+
+/* Output of the results, locked while a worker writes a line. */
+static FILE *output;
+static pidef_mutex_t output_lock = PIDEF_MUTEX_INIT;
+
+
+/*
+   Function declarations.
+*/
+
+/* Reads the jobs of the manifest from the given file. Returns non-zero on success. */
+int read_manifest(FILE *file);
+
+/* Parses the given manifest line (modifying it) into a job, setting its error if the line is invalid. */
+void parse_job(char *text, batch_job *job);
+
+/* Worker thread, which runs jobs until none are left. Takes in a pointer to the worker's index. */
+thread_func_t batch_worker(thread_arg_t data);
+
+/* Runs the job at the given index and writes its result. */
+void run_job(int index, int worker);
+
+/* Locks the output and writes the start of a job's line, or unlocks it after writing the end of the line. */
+void begin_result(int index, int worker, double seconds);
+void end_result(void);
+
+/* Writes the integer string of a constant multiplied by 10^digits with a decimal point. */
+void write_fixed_decimal(const char *str, long digits);
+
+int main(int argc, char *argv[]) {
+	/* Check for correct argument count. */
+	const char *output_path = NULL;
+	int positional = 0;
+	long num_workers = 0;
+	const char *manifest_path = NULL;
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--output") && i + 1 < argc) output_path = argv[++i];
+		else if (positional == 0) manifest_path = argv[i], ++positional;
+		else if (positional == 1) num_workers = strtol(argv[i], NULL, 10), ++positional;
+		else argc = 0;
+	}
+	if (argc < 2 || !manifest_path) {
+		fprintf(stderr, "Usage: %s manifest|- [num_workers] [--output results.jsonl]\nEngines:\n", *argv);
+		for (int i = 0; i < JOB_ENGINE_COUNT; ++i) {
+			fprintf(stderr, "  %s %s=N %s=N\n", job_engines[i].name, job_engines[i].params[0], job_engines[i].params[1]);
+		}
+		return EXIT_FAILURE;
+	}
+
+	/* Use one worker for each usable processor by default. */
+	if (positional < 2) {
+		pidef_topology_read(&pidef_tune_topology);
+		num_workers = pidef_tune_topology.cpus;
+	}
+	if (num_workers < 1) {
+		fprintf(stderr, "Number of workers must be at least 1.\n");
+		return EXIT_FAILURE;
+	}
+	if (num_workers > MAX_WORKERS) num_workers = MAX_WORKERS;
+
+	/* Read all jobs before running any, so a manifest that cannot be read runs nothing. */
+	FILE *const manifest = strcmp(manifest_path, "-") ? fopen(manifest_path, "r") : stdin;
+	if (!manifest) {
+		fprintf(stderr, "Could not open manifest '%s'.\n", manifest_path);
+		return EXIT_FAILURE;
+	}
+	const int read = read_manifest(manifest);
+	if (manifest != stdin) fclose(manifest);
+	if (!read) return EXIT_FAILURE;
+
+	output = output_path ? fopen(output_path, "w") : stdout;
+	if (!output) {
+		fprintf(stderr, "Could not open output '%s'.\n", output_path);
+		free(jobs);
+		return EXIT_FAILURE;
+	}
+
+	/* Workers beyond one per job would have nothing to do. */
+	if (num_workers > job_count) num_workers = job_count > 0 ? job_count : 1;
+	int *const worker_index = malloc((size_t)num_workers * sizeof *worker_index);
+	thread_id_t *const threads = malloc((size_t)num_workers * sizeof *threads);
+	if (!worker_index || !threads) {
+		fprintf(stderr, "Could not allocate memory for %ld workers.\n", num_workers);
+		if (output != stdout) fclose(output);
+		free(worker_index);
+		free(threads);
+		free(jobs);
+		return EXIT_FAILURE;
+	}
+
+	/* Stop taking new jobs when cancelled. */
+	pidef_cancel_install();
+
+	/* Start the pool, with the main thread as the last worker. */
+	const double start_time = pidef_wall_seconds();
+	for (int i = 0; i < num_workers; ++i) worker_index[i] = i;
+	for (int i = 0; i < num_workers - 1; ++i) pidef_create_thread(&threads[i], batch_worker, &worker_index[i]);
+	batch_worker(&worker_index[num_workers - 1]);
+	for (int i = 0; i < num_workers - 1; ++i) pidef_join_thread(threads[i]);
+	const double seconds = pidef_wall_seconds() - start_time;
+
+	/* Splits of cancelled constant jobs are kept for a checkpoint, which is not written here. */
+	bs_saved_free();
+	free(worker_index);
+	free(threads);
+	if (output != stdout) fclose(output);
+
+	/* Summarize the manifest to stderr, so the output only has results. */
+	const int jobs_run = next_job < job_count ? next_job : job_count;
+	fprintf(stderr, "Jobs: %d of %d run (%d failed) by %ld workers in %fs", jobs_run, job_count, jobs_failed, num_workers, seconds);
+	if (seconds > 0.0) fprintf(stderr, ", %.1f jobs/s", (double)jobs_run / seconds);
+	fputc('\n', stderr);
+	if (pidef_cancel_signal) fprintf(stderr, "Cancelled by signal %d\n", (int)pidef_cancel_signal);
+
+	free(jobs);
+	if (pidef_cancel_signal) return 128 + pidef_cancel_signal;
+	return jobs_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+/*
+   Function definitions.
+*/
+
+int read_manifest(FILE *file) {
+	char text[MAX_LINE_LENGTH];
+	int capacity = 0;
+	for (int line = 1; fgets(text, sizeof text, file); ++line) {
+		const size_t length = strlen(text);
+		if (length == sizeof text - 1 && text[length - 1] != '\n' && !feof(file)) {
+			fprintf(stderr, "Manifest line %d is longer than %d characters.\n", line, MAX_LINE_LENGTH - 2);
+			free(jobs);
+			return 0;
+		}
+
+		/* Skip blank and comment lines. */
+		const char *first = text;
+		while (*first == ' ' || *first == '\t') ++first;
+		if (*first == '#' || *first == '\n' || *first == '\r' || !*first) continue;
+
+		if (job_count == capacity) {
+			capacity = capacity ? capacity * 2 : 64;
+			batch_job *const grown = (batch_job*)realloc(jobs, (size_t)capacity * sizeof *jobs);
+			if (!grown) {
+				fprintf(stderr, "Could not allocate memory for %d jobs.\n", capacity);
+				free(jobs);
+				return 0;
+			}
+			jobs = grown;
+		}
+
+		batch_job *const job = &jobs[job_count++];
+		job->line = line;
+		parse_job(text, job);
+
+		/* Monte Carlo jobs without a seed are seeded with their job number, so each differs but is reproducible. */
+		if (!job->error && job->engine == JOB_MCARLO && !job->params[1]) job->params[1] = (uint64_t)job_count;
+	}
+
+	if (ferror(file)) {
+		fprintf(stderr, "Could not read the manifest.\n");
+		free(jobs);
+		return 0;
+	}
+	return 1;
+}
+
+void parse_job(char *text, batch_job *job) {
+	static const char *const separators = " \t\r\n";
+	char *token = strtok(text, separators);
+	job->engine = -1;
+	job->error = NULL;
+	memset(job->params, 0, sizeof job->params);
+
+	for (int i = 0; token && i < JOB_ENGINE_COUNT; ++i) if (!strcmp(token, job_engines[i].name)) job->engine = i;
+	if (job->engine < 0) {
+		job->error = "unknown engine";
+		return;
+	}
+	const job_engine *const engine = &job_engines[job->engine];
+
+	/* Each parameter is an unsigned integer in the range of the engine. */
+	while ((token = strtok(NULL, separators))) {
+		char *const equals = strchr(token, '=');
+		int param = -1;
+		if (equals) {
+			*equals = '\0';
+			for (int i = 0; i < JOB_MAX_PARAMS; ++i) if (!strcmp(token, engine->params[i])) param = i;
+		}
+		if (param < 0) {
+			job->error = "unknown parameter";
+			return;
+		}
+
+		char *end;
+		const unsigned long long value = strtoull(equals + 1, &end, 10);
+		if (end == equals + 1 || *end || equals[1] == '-') {
+			job->error = "invalid value";
+			return;
+		}
+		if (value < engine->min[param] || value > engine->max[param]) {
+			job->error = "value out of range";
+			return;
+		}
+		job->params[param] = (uint64_t)value;
+	}
+
+	/* Only the seed of Monte Carlo jobs is optional. */
+	for (int i = 0; i < JOB_MAX_PARAMS; ++i) {
+		if (!job->params[i] && !(job->engine == JOB_MCARLO && i == 1)) job->error = "missing parameter";
+	}
+}
+
+thread_func_t batch_worker(thread_arg_t data) {
+	const int worker = *(const int*)data;
+	for (int i; !pidef_cancel_signal && (i = pidef_atomic_inc_int(&next_job)) < job_count;) run_job(i, worker);
+	return NULL;
+}
+
+void run_job(int index, int worker) {
+	const batch_job *const job = &jobs[index];
+	if (job->error) {
+		pidef_atomic_inc_int(&jobs_failed);
+		begin_result(index, worker, 0.0);
+		fprintf(output, ",\"error\":\"%s\"", job->error);
+		end_result();
+		return;
+	}
+
+	const double start_time = pidef_wall_seconds();
+	switch (job->engine) {
+		case JOB_MCARLO: {
+			counter_t counters[2] = { 0, 0 };
+			pidef_rng rng;
+			pidef_rng_seed(&rng, PIDEF_RNG_LCG, job->params[1]);
+			generate_points(counters, job->params[0], &rng);
+			const double seconds = pidef_wall_seconds() - start_time;
+
+			begin_result(index, worker, seconds);
+			fprintf(output, ",\"inside\":%" PRIuLEAST64 ",\"outside\":%" PRIuLEAST64 ",\"pi\":%.17g", counters[1], counters[0],
+				4.0 * (double)counters[1] / (double)(counters[0] + counters[1]));
+			end_result();
+			break;
+		}
+		case JOB_SERIES: {
+			const series_func_data *const series = &series_function_data[job->params[0] - 1];
+			series_state state = series->initial;
+			series->address(&state, job->params[1]);
+			const double seconds = pidef_wall_seconds() - start_time;
+
+			begin_result(index, worker, seconds);
+			fprintf(output, ",\"name\":\"%s\",\"pi\":%.17g", series->given_name, state.res * series->multiplier);
+			end_result();
+			break;
+		}
+		case JOB_CONSTANT: {
+			/* Calculated as in pi_constants, but on this worker alone as the pool runs other jobs at the same time. */
+			const bs_series *const series = &bs_builtin_series[job->params[0] - 1];
+			const long digits = (long)job->params[1], calc_digits = digits + GUARD_DIGITS;
+			const uint64_t terms = bs_terms_needed(series, calc_digits);
+			const size_t prec = (size_t)((double)calc_digits * 3.321928094887362 / BN_LIMB_BITS) + 2;
+
+			bs_prepare_task prepare_task;
+			bs_prepare_start(&prepare_task, series, prec);
+
+			bs_result res;
+			bigint value;
+			bigint_init(&value);
+			/* Splits completed before a cancel are saved, and only used by jobs of the same series and precision. */
+			const int complete = bs_split(series, 0, terms, &res, 1, prec + BS_TRUNCATE_GUARD);
+			bs_prepare_join(&prepare_task);
+			if (!complete) {
+				pidef_atomic_inc_int(&jobs_failed);
+				begin_result(index, worker, pidef_wall_seconds() - start_time);
+				fprintf(output, ",\"error\":\"cancelled\"");
+				end_result();
+
+				bs_result_free(&res);
+				bigint_free(&prepare_task.value);
+				bigint_free(&value);
+				break;
+			}
+			series->finish(&value, &res, &prepare_task.value, prec);
+			bs_fixed_to_decimal(&value, &value, prec, digits);
+			char *const value_str = bigint_get_str(&value);
+			const double seconds = pidef_wall_seconds() - start_time;
+
+			begin_result(index, worker, seconds);
+			fprintf(output, ",\"name\":\"%s\",\"terms\":%" PRIu64 ",\"value\":\"", series->name, terms);
+			write_fixed_decimal(value_str, digits);
+			fputc('"', output);
+			end_result();
+
+			free(value_str);
+			bs_result_free(&res);
+			bigint_free(&prepare_task.value);
+			bigint_free(&value);
+			break;
+		}
+	}
+}
+
+void begin_result(int index, int worker, double seconds) {
+	const batch_job *const job = &jobs[index];
+	pidef_mutex_lock(&output_lock);
+	fprintf(output, "{\"job\":%d,\"line\":%d", index + 1, job->line);
+	if (job->engine >= 0) {
+		const job_engine *const engine = &job_engines[job->engine];
+		fprintf(output, ",\"engine\":\"%s\"", engine->name);
+		for (int i = 0; i < JOB_MAX_PARAMS; ++i) {
+			if (job->params[i]) fprintf(output, ",\"%s\":%" PRIu64, engine->params[i], job->params[i]);
+		}
+	}
+	fprintf(output, ",\"worker\":%d,\"seconds\":%f", worker, seconds);
+}
+
+void end_result(void) {
+	/* Each line is flushed as it is written, so a pipeline reading the output sees results as they finish. */
+	fputs("}\n", output);
+	fflush(output);
+	pidef_mutex_unlock(&output_lock);
+}
+
+void write_fixed_decimal(const char *str, long digits) {
+	const long length = (long)strlen(str);
+
+	/* Integer part, which is 0 if there are no more digits than the fractional part. */
+	if (length > digits) fwrite(str, 1, (size_t)(length - digits), output);
+	else fputc('0', output);
+	fputc('.', output);
+
+	/* Fractional part, including any leading zeros not in the string. */
+	for (long i = length; i < digits; ++i) fputc('0', output);
+	fputs(length > digits ? str + length - digits : str, output);
+}
@@ -0,0 +1,432 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Compares two benchmark results (such as pi_microbench --json of a baseline and a candidate build) kernel by
+   kernel, deciding from their repeated samples whether each one became slower, faster or did not change, so
+   that noise in single timings does not fail (or pass) a performance check by chance.
+
+   Each kernel's change is the ratio of the candidate's median to the baseline's median. A bootstrap confidence
+   interval of the ratio is found by resampling both sets of samples with replacement, and a two-sided Mann-Whitney
+   U test (with the normal approximation, corrected for ties) gives the probability of a difference at least as
+   large without a real change. A kernel only counts as a regression when the test is significant and the whole
+   interval is slower by more than the threshold, and likewise for an improvement.
+
+   The files are JSON objects with a "benchmarks" array, whose objects have a "name" and a "samples" array of
+   numbers where lower is better (such as cycles or seconds). Other members are ignored. The exit code is 1 when
+   any kernel regressed, for use in scripts.
+
+   The JSON lines written by pi_batch are read as well, so the engines can be compared by running a manifest that
+   repeats the same jobs. Jobs with the same engine and parameters (the members between "engine" and "worker",
+   except the seed of Monte Carlo jobs, which differs between jobs by default) are one kernel, such as
+   "constant constant=2 digits=50", and the "seconds" of each is a sample. Jobs with an "error" are skipped.
+
+   See https://en.wikipedia.org/wiki/Bootstrapping_(statistics) and
+   https://en.wikipedia.org/wiki/Mann%E2%80%93Whitney_U_test for more information.
+*/
+
+/* Required includes. */
+#include "c_random.h"
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <math.h>
+
+/* Default significance level, smallest relative change that counts, and bootstrap resamples. */
+#define CMP_ALPHA 0.01
+#define CMP_THRESHOLD 0.05
+#define CMP_RESAMPLES 10000
+
+/* Confidence of the bootstrap interval. */
+#define CMP_CONFIDENCE 0.95
+
+/* Samples of one kernel. */
+typedef struct {
+	char *name;
+	double *samples;
+	int count;
+} bench_result;
+
+/* All kernels of one file. */
+typedef struct {
+	bench_result *results;
+	int count;
+} bench_file;
+
+/* Outcome of the comparison of one kernel. */
+typedef struct {
+	double baseline_median, candidate_median, ratio, ratio_low, ratio_high, p_value;
+	int verdict; /* 1 if it regressed, -1 if it improved, 0 if there was no significant change. */
+} bench_comparison;
+
+
+/*
+   Function declarations.
+*/
+
+/* Reads the kernels of a benchmark results file, returning non-zero on success. */
+int read_bench_file(const char *path, bench_file *file);
+
+/* Frees the kernels of a file. */
+void free_bench_file(bench_file *file);
+
+/* Compares the samples of a kernel, with the given significance level and threshold. */
+void compare_results(const bench_result *baseline, const bench_result *candidate, double alpha, double threshold,
+	bench_comparison *comparison);
+
+/* Returns the median of the values, which are sorted in place. */
+double median(double *values, int count);
+
+/* Returns the two-sided p-value of the Mann-Whitney U test of two sets of samples. */
+double mann_whitney_p(const double *a, int an, const double *b, int bn);
+
+int main(int argc, char *argv[]) {
+	/* Check for the correct arguments: the two files, and the options. */
+	const char *paths[2] = { NULL, NULL };
+	double alpha = CMP_ALPHA, threshold = CMP_THRESHOLD;
+	int file_count = 0, valid = 1;
+	for (int i = 1; i < argc && valid; ++i) {
+		if (!strcmp(argv[i], "--alpha") && i + 1 < argc) alpha = strtod(argv[++i], NULL);
+		else if (!strcmp(argv[i], "--threshold") && i + 1 < argc) threshold = strtod(argv[++i], NULL) / 100.0;
+		else if (!strncmp(argv[i], "--", 2) || file_count == 2) valid = 0;
+		else paths[file_count++] = argv[i];
+	}
+	if (!valid || file_count != 2 || alpha <= 0.0 || alpha >= 1.0 || threshold < 0.0) {
+		fprintf(stderr, "Usage: %s baseline.json candidate.json [--alpha level] [--threshold percent]\n"
+			"Defaults: --alpha %g --threshold %g\n", *argv, CMP_ALPHA, CMP_THRESHOLD * 100.0);
+		return EXIT_FAILURE;
+	}
+
+	bench_file baseline, candidate;
+	if (!read_bench_file(paths[0], &baseline)) return EXIT_FAILURE;
+	if (!read_bench_file(paths[1], &candidate)) {
+		free_bench_file(&baseline);
+		return EXIT_FAILURE;
+	}
+
+	/* The names are padded to the longest one, such as the parameters of pi_batch jobs. */
+	int width = 24;
+	for (int i = 0; i < baseline.count; ++i) if ((int)strlen(baseline.results[i].name) > width) width = (int)strlen(baseline.results[i].name);
+	for (int j = 0; j < candidate.count; ++j) if ((int)strlen(candidate.results[j].name) > width) width = (int)strlen(candidate.results[j].name);
+
+	printf("%-*s %12s %12s %9s %19s %9s  %s\n", width, "Kernel", "Baseline", "Candidate", "Change", "95% interval", "p-value", "Verdict");
+	int regressions = 0, improvements = 0, compared = 0;
+	for (int i = 0; i < baseline.count; ++i) {
+		const bench_result *const base = &baseline.results[i];
+		const bench_result *cand = NULL;
+		for (int j = 0; j < candidate.count && !cand; ++j) if (!strcmp(candidate.results[j].name, base->name)) cand = &candidate.results[j];
+		if (!cand) {
+			printf("%-*s only in the baseline\n", width, base->name);
+			continue;
+		}
+
+		bench_comparison cmp;
+		compare_results(base, cand, alpha, threshold, &cmp);
+		printf("%-*s %12.4g %12.4g %+8.2f%% [%+7.2f%%, %+7.2f%%] %9.2g  %s\n", width, base->name, cmp.baseline_median,
+			cmp.candidate_median, (cmp.ratio - 1.0) * 100.0, (cmp.ratio_low - 1.0) * 100.0, (cmp.ratio_high - 1.0) * 100.0,
+			cmp.p_value, cmp.verdict > 0 ? "REGRESSION" : cmp.verdict < 0 ? "improvement" : "no change");
+
+		regressions += cmp.verdict > 0;
+		improvements += cmp.verdict < 0;
+		++compared;
+	}
+	for (int j = 0; j < candidate.count; ++j) {
+		int found = 0;
+		for (int i = 0; i < baseline.count && !found; ++i) found = !strcmp(candidate.results[j].name, baseline.results[i].name);
+		if (!found) printf("%-*s only in the candidate\n", width, candidate.results[j].name);
+	}
+
+	printf("\n%d kernel(s) compared: %d regression(s), %d improvement(s) (alpha %g, threshold %g%%)\n",
+		compared, regressions, improvements, alpha, threshold * 100.0);
+
+	free_bench_file(&baseline);
+	free_bench_file(&candidate);
+	return regressions ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+/*
+   Function definitions.
+*/
+
+/* Skips whitespace, returning the next character. */
+static const char *skip_space(const char *p) {
+	while (isspace((unsigned char)*p)) ++p;
+	return p;
+}
+
+/* Reads a JSON string starting at its opening quote into a new allocation (escapes are kept as they are). */
+static const char *read_string(const char *p, char **out) {
+	const char *const start = ++p;
+	while (*p && *p != '"') p += *p == '\\' && p[1] ? 2 : 1;
+	if (out) {
+		*out = (char*)malloc((size_t)(p - start) + 1);
+		if (*out) {
+			memcpy(*out, start, (size_t)(p - start));
+			(*out)[p - start] = '\0';
+		}
+	}
+	return *p ? p + 1 : p;
+}
+
+/* Appends a sample to the kernel with the given name, adding the kernel if there is none. Returns non-zero on success. */
+static int add_sample(bench_file *file, int *capacity, const char *name, double sample) {
+	bench_result *result = NULL;
+	for (int i = 0; i < file->count && !result; ++i) if (!strcmp(file->results[i].name, name)) result = &file->results[i];
+
+	if (!result) {
+		if (file->count == *capacity) {
+			*capacity = *capacity ? *capacity * 2 : 32;
+			bench_result *const grown = (bench_result*)realloc(file->results, sizeof(bench_result) * (size_t)*capacity);
+			if (!grown) return 0;
+			file->results = grown;
+		}
+		result = &file->results[file->count];
+		result->name = (char*)malloc(strlen(name) + 1);
+		if (!result->name) return 0;
+		strcpy(result->name, name);
+		result->samples = NULL;
+		result->count = 0;
+		++file->count;
+	}
+
+	double *const grown = (double*)realloc(result->samples, sizeof(double) * (size_t)(result->count + 1));
+	if (!grown) return 0;
+	result->samples = grown;
+	result->samples[result->count++] = sample;
+	return 1;
+}
+
+/* Reads an array of numbers starting at its opening bracket. */
+static const char *read_numbers(const char *p, double **values, int *count) {
+	int capacity = 16;
+	*count = 0;
+	*values = (double*)malloc(sizeof(double) * (size_t)capacity);
+	for (p = skip_space(p + 1); *p && *p != ']'; p = skip_space(p)) {
+		char *end;
+		const double value = strtod(p, &end);
+		if (end == p) return p;
+		p = end;
+
+		if (*count == capacity) {
+			capacity *= 2;
+			double *const grown = (double*)realloc(*values, sizeof(double) * (size_t)capacity);
+			if (!grown) return p;
+			*values = grown;
+		}
+		if (*values) (*values)[(*count)++] = value;
+		if (*(p = skip_space(p)) == ',') ++p;
+	}
+	return *p ? p + 1 : p;
+}
+
+int read_bench_file(const char *path, bench_file *file) {
+	file->results = NULL;
+	file->count = 0;
+
+	FILE *const input = fopen(path, "rb");
+	if (!input) {
+		fprintf(stderr, "Could not open \"%s\".\n", path);
+		return 0;
+	}
+	fseek(input, 0, SEEK_END);
+	const long size = ftell(input);
+	fseek(input, 0, SEEK_SET);
+	char *const text = (char*)malloc((size_t)(size > 0 ? size : 0) + 1);
+	if (!text) {
+		fclose(input);
+		fprintf(stderr, "Could not allocate memory for \"%s\".\n", path);
+		return 0;
+	}
+	text[fread(text, 1, (size_t)(size > 0 ? size : 0), input)] = '\0';
+	fclose(input);
+
+	/*
+	   Every object with both a "name" and a "samples" member is a kernel, so the scanner only has to recognise
+	   those two keys, skipping over other strings so quotes and brackets inside them are not mistaken for structure.
+	   Objects of pi_batch are recognised by their "engine", and add their "seconds" to the kernel of their parameters.
+	*/
+	char *name = NULL;
+	double *samples = NULL;
+	int sample_count = 0, capacity = 0, valid = 1;
+	char job_name[256];
+	double job_seconds = -1.0; /* Negative until the job's seconds are read. */
+	int job_state = 0; /* 0 outside of a job, 1 reading its parameters, 2 after them, -1 if the job is skipped. */
+	for (const char *p = text; *p && valid;) {
+		if (*p == '{' || *p == '}') {
+			if (*p == '}' && job_state == 2 && job_seconds >= 0.0 && !add_sample(file, &capacity, job_name, job_seconds)) valid = 0;
+			job_state = 0;
+			job_seconds = -1.0;
+
+			if (*p == '}' && name && samples) {
+				if (file->count == capacity) {
+					capacity = capacity ? capacity * 2 : 32;
+					bench_result *const grown = (bench_result*)realloc(file->results, sizeof(bench_result) * (size_t)capacity);
+					if (!grown) {
+						valid = 0;
+						break;
+					}
+					file->results = grown;
+				}
+				file->results[file->count].name = name;
+				file->results[file->count].samples = samples;
+				file->results[file->count++].count = sample_count;
+				name = NULL;
+				samples = NULL;
+			}
+
+			/* Members of an object only belong to the kernel if they are directly inside it. */
+			free(name);
+			free(samples);
+			name = NULL;
+			samples = NULL;
+			++p;
+		} else if (*p == '"') {
+			char *key;
+			p = skip_space(read_string(p, &key));
+			if (!key) valid = 0;
+			else if (*p == ':') {
+				p = skip_space(p + 1);
+				if (!strcmp(key, "engine") && *p == '"') {
+					char *engine;
+					p = read_string(p, &engine);
+					if (!engine) valid = 0;
+					else {
+						snprintf(job_name, sizeof job_name, "%s", engine);
+						job_state = 1;
+					}
+					free(engine);
+				} else if (job_state == 1 && !strcmp(key, "worker")) job_state = 2;
+				else if (job_state == 1 && strcmp(key, "seed")) {
+					/* Parameters are numbers, added to the name as they were written. */
+					const char *const value = p;
+					while (*p && *p != ',' && *p != '}' && !isspace((unsigned char)*p)) ++p;
+					const size_t used = strlen(job_name);
+					snprintf(job_name + used, sizeof job_name - used, " %s=%.*s", key, (int)(p - value), value);
+				} else if (job_state != 0 && !strcmp(key, "seconds")) job_seconds = strtod(p, NULL);
+				else if (job_state != 0 && !strcmp(key, "error")) job_state = -1;
+				else if (!strcmp(key, "name") && *p == '"') {
+					free(name);
+					p = read_string(p, &name);
+				} else if (!strcmp(key, "samples") && *p == '[') {
+					free(samples);
+					p = read_numbers(p, &samples, &sample_count);
+					if (!samples || sample_count < 1) valid = 0;
+				}
+			}
+			free(key);
+		} else ++p;
+	}
+
+	free(name);
+	free(samples);
+	free(text);
+	if (!valid || !file->count) {
+		fprintf(stderr, "No benchmark samples found in \"%s\".\n", path);
+		free_bench_file(file);
+		return 0;
+	}
+	return 1;
+}
+
+void free_bench_file(bench_file *file) {
+	for (int i = 0; i < file->count; ++i) {
+		free(file->results[i].name);
+		free(file->results[i].samples);
+	}
+	free(file->results);
+	file->results = NULL;
+	file->count = 0;
+}
+
+/* Ascending order for qsort. */
+static int compare_doubles(const void *a, const void *b) {
+	const double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+double median(double *values, int count) {
+	qsort(values, (size_t)count, sizeof *values, compare_doubles);
+	return count % 2 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2.0;
+}
+
+double mann_whitney_p(const double *a, int an, const double *b, int bn) {
+	/* Rank the combined samples, giving tied values the average of their ranks. */
+	const int n = an + bn;
+	double *const values = (double*)malloc(sizeof(double) * (size_t)n);
+	if (!values) return 1.0;
+	memcpy(values, a, sizeof(double) * (size_t)an);
+	memcpy(values + an, b, sizeof(double) * (size_t)bn);
+	qsort(values, (size_t)n, sizeof *values, compare_doubles);
+
+	/* Sum of the ranks of 'a', and the tie correction sum of t^3 - t over groups of t tied values. */
+	double rank_sum = 0.0, ties = 0.0;
+	for (int i = 0; i < n;) {
+		int j = i;
+		while (j < n && values[j] == values[i]) ++j;
+		const double rank = (i + 1 + j) / 2.0, t = j - i;
+		for (int k = 0; k < an; ++k) if (a[k] == values[i]) rank_sum += rank;
+		ties += t * t * t - t;
+		i = j;
+	}
+	free(values);
+
+	const double u = rank_sum - (double)an * (an + 1) / 2.0, mean = (double)an * bn / 2.0;
+	const double variance = (double)an * bn / 12.0 * ((n + 1) - ties / ((double)n * (n - 1)));
+	if (variance <= 0.0) return 1.0;
+
+	/* Normal approximation with a continuity correction. */
+	const double z = (fabs(u - mean) - 0.5) / sqrt(variance);
+	return z <= 0.0 ? 1.0 : erfc(z / sqrt(2.0));
+}
+
+/* Returns a uniformly random index below 'n'. */
+static int random_index(uint64_t *state, int n) {
+	const int index = (int)(xorshift01(state) * (float)n);
+	return index < n ? index : n - 1;
+}
+
+void compare_results(const bench_result *baseline, const bench_result *candidate, double alpha, double threshold,
+	bench_comparison *comparison)
+{
+	const int bn = baseline->count, cn = candidate->count;
+	double *const base_copy = (double*)malloc(sizeof(double) * (size_t)(bn + cn));
+	double *const resample = (double*)malloc(sizeof(double) * (size_t)(bn > cn ? bn : cn));
+	double *const ratios = (double*)malloc(sizeof(double) * CMP_RESAMPLES);
+	if (!base_copy || !resample || !ratios) {
+		fprintf(stderr, "Could not allocate memory for the comparison.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	double *const cand_copy = base_copy + bn;
+	memcpy(base_copy, baseline->samples, sizeof(double) * (size_t)bn);
+	memcpy(cand_copy, candidate->samples, sizeof(double) * (size_t)cn);
+	comparison->baseline_median = median(base_copy, bn);
+	comparison->candidate_median = median(cand_copy, cn);
+	comparison->ratio = comparison->candidate_median / comparison->baseline_median;
+	comparison->p_value = mann_whitney_p(baseline->samples, bn, candidate->samples, cn);
+
+	/* Bootstrap the ratio of medians, with a fixed seed so the same files always give the same interval. */
+	uint64_t state = UINT64_C(0x9E3779B97F4A7C15);
+	for (int r = 0; r < CMP_RESAMPLES; ++r) {
+		for (int i = 0; i < bn; ++i) resample[i] = baseline->samples[random_index(&state, bn)];
+		const double base_median = median(resample, bn);
+		for (int i = 0; i < cn; ++i) resample[i] = candidate->samples[random_index(&state, cn)];
+		ratios[r] = median(resample, cn) / base_median;
+	}
+	qsort(ratios, CMP_RESAMPLES, sizeof *ratios, compare_doubles);
+	comparison->ratio_low = ratios[(int)((1.0 - CMP_CONFIDENCE) / 2.0 * CMP_RESAMPLES)];
+	comparison->ratio_high = ratios[(int)((1.0 + CMP_CONFIDENCE) / 2.0 * CMP_RESAMPLES) - 1];
+
+	comparison->verdict = 0;
+	if (comparison->p_value < alpha) {
+		if (comparison->ratio_low > 1.0 + threshold) comparison->verdict = 1;
+		else if (comparison->ratio_high < 1.0 - threshold) comparison->verdict = -1;
+	}
+
+	free(base_copy);
+	free(resample);
+	free(ratios);
+}
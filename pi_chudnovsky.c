@@ -10,6 +10,20 @@
    instead of relying on the raw formula. The result is an *integer* value that represents the value
    of pi (i.e. 3141... instead of 3.141...).
 
+   The series itself is calculated by the generic binary splitting engine (see c_binsplit.h), which
+   can split the top of the tree across threads. All values are stored as arbitrary precision integers
+   (see c_bignum.h), as the P, Q and T values quickly become far larger than any built-in type can hold.
+   The products in each merge of the binary splitting can have very different sizes, which the
+   unbalanced multiplication tiers handle.
+
+   With --decimal-limbs, the calculation uses integers in base 10^9 instead (see c_decnum.h), so the digits
+   are printed without converting from binary. The time of each stage is printed to compare both.
+   When built with GMP, --gmp calculates with GMP integers instead (see c_gmpref.h), and --compare-gmp
+   calculates with both, checking that the digits match and comparing the times.
+
+   With binary limbs, Ctrl-C or SIGTERM stops the calculation at the next split of the series (or once the
+   finish is done) and saves what was calculated as a checkpoint, which --resume continues from.
+
    The original Python source can be seen here: https://www.craig-wood.com/nick/articles/pi-chudnovsky/
    This is a C adaptation of the Python source.
 
@@ -20,76 +34,415 @@
 */
 
 /* Required includes. */
+#include "c_binsplit.h"
+#include "c_bench.h"
+#include "c_gmpref.h"
+#include "c_progress.h"
 #include <inttypes.h>
+#include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
-#include <math.h>
 #include <time.h>
 
-/* Types to use for storing calculations. */
-typedef uint_least64_t pi_uint;
-typedef double pi_flt;
+/* Number of extra digits calculated to avoid rounding errors in the last digits. */
+#define GUARD_DIGITS 10
+
+/* Checkpoint written when cancelled, if --checkpoint was not given. */
+#define CANCEL_CHECKPOINT "pi_chudnovsky.checkpoint"
+
+/*
+   Saves a checkpoint of the series of 'terms' terms after a cancellation, returning the exit code of the program.
+   The complete series is saved if 'res' is not NULL, otherwise the splits that were saved when it was cancelled.
+*/
+int save_cancelled(const char *path, uint64_t terms, const bs_result *res);
+
+/* Energy used by the whole calculation, including the conversion to decimal. */
+static pidef_energy energy;
+
+/* Progress of the series, reported if --progress is given. */
+static pidef_progress series_progress;
+
+/* Starts reporting the progress of the series if it was requested. */
+void start_series_progress(int show_progress, uint64_t terms);
+
+/* Stops reporting the progress of the series, if it was started. */
+void stop_series_progress(void);
 
-/* Structure used for calculations and results. */
-typedef struct { pi_flt Pab, Qab, Tab; } result_flts;
+/* Arithmetic used for the calculation. */
+enum { BACKEND_BINARY, BACKEND_DECIMAL, BACKEND_GMP };
+static const char *const backend_names[] = { "binary limbs", "decimal limbs", "GMP" };
 
 /*
-   Uses a binary-splitting version of Chudnovsky's algorithm to calculate pi.
-   Returns a struct of specific values used to calculate an integer representation of pi.
+   Calculates the digits of pi with decimal limbs or GMP, returning them as a string freed with other_backend_free_str.
+   Sets 'stage_ends' to the wall time at the end of the series, finish and conversion stages.
 */
-result_flts chudnovsky_binarysplit(pi_uint a, pi_uint b);
+char *other_backend_pi_str(int backend, long digits, long calc_digits, uint64_t terms, int num_threads, double stage_ends[3]);
+
+/* Frees a string of other_backend_pi_str, through GMP's allocator for GMP strings so counted memory stays balanced. */
+void other_backend_free_str(int backend, char *pi_str);
+
+/* Calculates and prints pi using decimal limbs or GMP, returning the exit code of the program. */
+int other_backend_pi(int backend, long digits, long calc_digits, uint64_t terms, int num_threads, const char *output_path,
+	clock_t start_time, double wall_start);
 
 int main(int argc, char *argv[]) {
 	/* Validate arguments count. */
-	if (argc != 2) {
-		fprintf(stderr, "Usage: %s pi_digits\n", *argv);
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s pi_digits [options]\nOptions:\n  --no-huge-pages - Use normal pages for large buffers\n"
+			"  --threads N     - Split the top of the binary splitting tree across N threads (default 1)\n"
+			"  --verify-muls   - Check large products modulo a random prime, recalculating wrong ones\n"
+			"  --output FILE   - Write the digits to FILE instead of printing them\n"
+			"  --checkpoint FILE - Save the series results to FILE while pi is finished, or when cancelled\n"
+			"  --resume FILE   - Continue from the series results in a matching checkpoint instead of calculating them\n"
+			"  --decimal-limbs - Calculate with base 10^9 limbs, which need no conversion to print\n"
+			"  --exact-split   - Keep every limb of the series values instead of truncating them to the needed precision\n"
+			"  --gmp           - Calculate with GMP integers (if built with GMP)\n"
+			"  --compare-gmp   - Also calculate with GMP, checking the digits and comparing the times\n"
+			"  --progress      - Report the progress of the series to stderr\n"
+			"  --memory        - Report the allocations and peak memory of each stage\n", *argv);
 		return EXIT_FAILURE;
 	}
 
+	/* Optional flags after the digits count. */
+	int num_threads = 1, backend = BACKEND_BINARY, exact_split = 0, compare_gmp = 0, show_progress = 0, track_memory = 0;
+	const char *output_path = NULL, *checkpoint_path = NULL, *resume_path = NULL;
+	for (int i = 2; i < argc; ++i) {
+		if (!strcmp(argv[i], "--no-huge-pages")) bn_huge_page_bytes = SIZE_MAX;
+		else if (!strcmp(argv[i], "--threads") && i + 1 < argc) num_threads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--output") && i + 1 < argc) output_path = argv[++i];
+		else if (!strcmp(argv[i], "--checkpoint") && i + 1 < argc) checkpoint_path = argv[++i];
+		else if (!strcmp(argv[i], "--resume") && i + 1 < argc) resume_path = argv[++i];
+		else if (!strcmp(argv[i], "--decimal-limbs")) backend = BACKEND_DECIMAL;
+		else if (!strcmp(argv[i], "--gmp")) backend = BACKEND_GMP;
+		else if (!strcmp(argv[i], "--compare-gmp")) compare_gmp = 1;
+		else if (!strcmp(argv[i], "--progress")) show_progress = 1;
+		else if (!strcmp(argv[i], "--memory")) track_memory = 1;
+		else if (!strcmp(argv[i], "--exact-split")) exact_split = 1;
+		else if (!strcmp(argv[i], "--verify-muls")) bn_verify_enable((uint64_t)time(NULL) ^ ((uint64_t)clock() << 32));
+		else {
+			fprintf(stderr, "Unknown option \"%s\".\n", argv[i]);
+			return EXIT_FAILURE;
+		}
+	}
+
 	/* Get and validate pi digits accuracy. */
-	const long digits = strtol(argv[1], NULL, 10) * 2;
-	if (digits < 0)  {
+	const long digits = strtol(argv[1], NULL, 10);
+	if (digits <= 0)  {
 		fprintf(stderr, "Digits count must be larger than 0.\n");
 		return EXIT_FAILURE;
 	} 
 
-	/* Start timer. */
+	if (num_threads <= 0) {
+		fprintf(stderr, "Thread count must be larger than 0.\n");
+		return EXIT_FAILURE;
+	}
+
+	if (backend != BACKEND_BINARY && (checkpoint_path || resume_path || bn_verify_prime || compare_gmp)) {
+		fprintf(stderr, "Checkpoints, product verification and comparisons are only supported with binary limbs.\n");
+		return EXIT_FAILURE;
+	}
+
+	#ifndef PI_HAVE_GMP
+	if (backend == BACKEND_GMP || compare_gmp) {
+		fprintf(stderr, "This program was built without GMP.\n");
+		return EXIT_FAILURE;
+	}
+	#endif
+
+	/* Count allocations by stage, including GMP's, from before anything is allocated. */
+	if (track_memory) {
+		#ifdef PI_HAVE_GMP
+		bs_gmp_count_memory();
+		#endif
+		pidef_memory_start("series");
+	}
+
+	/* Start timer, TLB miss counter and energy measurement. */
+	pidef_counter dtlb_misses;
+	pidef_counter_start_dtlb(&dtlb_misses);
+	pidef_energy_start(&energy);
 	const clock_t start_time = clock();
+	const double wall_start = pidef_wall_seconds();
 
-	/* Calculate pi and output the result. */
-	const result_flts res = chudnovsky_binarysplit(0, (pi_uint)((pi_flt)digits / 14.181647462725477) + (pi_uint)(1U));
-	const pi_uint pi = ((res.Qab * 426880.0 * sqrt(10005.0 * pow(10.0, (double)digits))) / res.Tab);
-	
-	/* End timer. */
+	/* Calculate the binary splitting values. Each term adds roughly 14.18 digits. */
+	const bs_series *const series = &bs_builtin_series[BS_PI];
+	const long calc_digits = digits + GUARD_DIGITS;
+	const uint64_t terms = bs_terms_needed(series, calc_digits);
+	if (backend != BACKEND_BINARY) {
+		start_series_progress(show_progress, terms);
+		return other_backend_pi(backend, digits, calc_digits, terms, num_threads, output_path, start_time, wall_start);
+	}
+	bs_result res;
+
+	/*
+	   pi = (426880 * sqrt(10005) * Q) / T, calculated in fixed point with 'prec' limbs after the point
+	   using Newton reciprocal and inverse square root iterations (sqrt(10005) = 10005 / sqrt(10005)).
+	   The square root does not depend on the series, so it is calculated in another thread at the same time.
+	*/
+	const size_t prec = (size_t)((double)calc_digits * 3.321928094887362 / BN_LIMB_BITS) + 2;
+	bs_prepare_task sqrt_task;
+	bs_prepare_start(&sqrt_task, series, prec);
+
+	const size_t max_limbs = exact_split ? 0 : prec + BS_TRUNCATE_GUARD;
+	if (resume_path) {
+		const uint64_t resumed = bs_checkpoint_read(resume_path, BS_PI, terms, max_limbs);
+		if (resumed) printf("Resumed %" PRIu64 " of %" PRIu64 " terms from checkpoint \"%s\".\n", resumed, terms, resume_path);
+		else printf("Checkpoint \"%s\" is missing or does not match, calculating the series.\n", resume_path);
+	}
+
+	/* Saved splits of the checkpoint are used in place of calculating them, and are freed if any are left. */
+	pidef_cancel_install();
+	start_series_progress(show_progress, terms);
+	const int series_complete = bs_split(series, 0, terms, &res, num_threads, max_limbs);
+	stop_series_progress();
+	if (!series_complete) return save_cancelled(checkpoint_path ? checkpoint_path : CANCEL_CHECKPOINT, terms, NULL);
+	bs_saved_free();
+
+	/* Save the checkpoint in the background while pi is finished. */
+	pidef_writer checkpoint;
+	if (checkpoint_path) {
+		if (!pidef_writer_open(&checkpoint, checkpoint_path)) {
+			fprintf(stderr, "Could not open checkpoint file \"%s\".\n", checkpoint_path);
+			return EXIT_FAILURE;
+		}
+		bs_checkpoint_write(&checkpoint, BS_PI, terms, &res);
+	}
+
+	const double series_end = pidef_wall_seconds();
+	bs_prepare_join(&sqrt_task);
+	const double sqrt_wait = pidef_wall_seconds() - series_end;
+	pidef_memory_phase_next("finish");
+
+	bigint pi;
+	bigint_init(&pi);
+	series->finish(&pi, &res, &sqrt_task.value, prec);
+
+	/* The finish cannot be stopped part way, but the conversion after it is skipped. */
+	if (pidef_cancel_signal) {
+		if (!checkpoint_path) return save_cancelled(CANCEL_CHECKPOINT, terms, &res);
+		const int write_failed = !pidef_writer_close(&checkpoint);
+		printf("Cancelled by signal %d after the series. ", (int)pidef_cancel_signal);
+		if (write_failed) printf("Could not write checkpoint \"%s\".\n", checkpoint_path);
+		else printf("Saved it to \"%s\", continue with --resume %s\n", checkpoint_path, checkpoint_path);
+		return 128 + pidef_cancel_signal;
+	}
+
+	/* Convert the fixed point result to the integer pi * 10^digits. */
+	bs_fixed_to_decimal(&pi, &pi, prec, digits);
+
+	/* End timer. Note that clock() counts the time of all threads on POSIX systems. */
 	const clock_t end_time = clock();
+	const double finish_end = pidef_wall_seconds();
+	pidef_counter_stop(&dtlb_misses);
+	pidef_memory_phase_next("conversion");
 	
-	printf("Pi approximation: %" PRIu64 "\nTime taken: %fs\n", pi, (double)(end_time - start_time) / CLOCKS_PER_SEC);
+	char *const pi_str = bigint_get_str(&pi);
+	const double convert_end = pidef_wall_seconds();
+	pidef_energy_stop(&energy);
+	pidef_memory_phase_next(NULL);
+	pidef_writer output;
+	if (output_path) {
+		/* The digits are written while the rest of the results are printed. */
+		if (!pidef_writer_open(&output, output_path)) {
+			fprintf(stderr, "Could not open output file \"%s\".\n", output_path);
+			return EXIT_FAILURE;
+		}
+		pidef_writer_write(&output, pi_str, strlen(pi_str));
+		pidef_writer_write(&output, "\n", 1);
+		printf("Pi approximation: written to \"%s\"\nTime taken: %fs\n", output_path, (double)(end_time - start_time) / CLOCKS_PER_SEC);
+	} else printf("Pi approximation: %s\nTime taken: %fs\n", pi_str, (double)(end_time - start_time) / CLOCKS_PER_SEC);
 
-	return EXIT_SUCCESS;
+	/* Memory statistics, to compare runs with and without huge pages. */
+	printf("Large buffers: %" PRIu64 " (%" PRIu64 " hugetlbfs, %" PRIu64 " transparent huge pages)\n", pidef_atomic_load(&bn_large_allocs),
+		pidef_atomic_load(&bn_hugetlb_allocs), pidef_atomic_load(&bn_thp_allocs));
+	printf("Transform buffers: %lu allocated, %lu reused from the pool\n", bn_scratch_allocs, bn_scratch_reuses);
+	pidef_counter_print(&dtlb_misses, "dTLB misses");
+	pidef_energy_print(&energy, (double)digits, "digits");
+	pidef_memory_print();
+	printf("Square root of 10005: %fs, overlapped with the series except for %fs\n", sqrt_task.seconds, sqrt_wait);
+	printf("Stages: %fs series, %fs finish, %fs conversion to decimal (wall time)\n",
+		series_end - wall_start, finish_end - series_end, convert_end - finish_end);
+	if (bn_verify_prime) {
+		printf("Verified products: %" PRIu64 " (%" PRIu64 " failed checks, prime %" PRIu64 ")\n", pidef_atomic_load(&bn_verified_muls),
+			pidef_atomic_load(&bn_verify_failures), bn_verify_prime);
+	}
+
+	/* Recalculate with GMP after the timings above, so both calculations have the machine to themselves. */
+	int compare_failed = 0;
+	if (compare_gmp) {
+		double gmp_ends[3];
+		const double gmp_start = pidef_wall_seconds();
+		char *const gmp_str = other_backend_pi_str(BACKEND_GMP, digits, calc_digits, terms, num_threads, gmp_ends);
+		printf("GMP stages: %fs series, %fs finish, %fs conversion to decimal (wall time)\n",
+			gmp_ends[0] - gmp_start, gmp_ends[1] - gmp_ends[0], gmp_ends[2] - gmp_ends[1]);
+		printf("Binary limbs took %.2fx the time of GMP\n", (convert_end - wall_start) / (gmp_ends[2] - gmp_start));
+
+		size_t mismatch = 0;
+		while (pi_str[mismatch] && pi_str[mismatch] == gmp_str[mismatch]) ++mismatch;
+		compare_failed = pi_str[mismatch] != gmp_str[mismatch];
+		if (compare_failed) printf("Digits differ from GMP at position %zu\n", mismatch);
+		else printf("All digits match GMP\n");
+		other_backend_free_str(BACKEND_GMP, gmp_str);
+	}
+
+	/* Wait for any remaining writes, reporting how much of their time was spent calculating instead. */
+	int write_failed = 0;
+	if (checkpoint_path) {
+		write_failed |= !pidef_writer_close(&checkpoint);
+		pidef_writer_print_stats(&checkpoint, "Checkpoint");
+	}
+	if (output_path) {
+		write_failed |= !pidef_writer_close(&output);
+		pidef_writer_print_stats(&output, "Output");
+	}
+
+	free(pi_str);
+	bs_result_free(&res);
+	bigint_free(&sqrt_task.value);
+	bigint_free(&pi);
+	bn_ntt_cache_free();
+
+	if (write_failed) {
+		fprintf(stderr, "Could not write all output.\n");
+		return EXIT_FAILURE;
+	}
+	return compare_failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
-result_flts chudnovsky_binarysplit(pi_uint a, pi_uint b) {
-	result_flts res;
-	if (b - a == 1) {
-		if (!a) res.Pab = res.Qab = 1.0;
-		else {
-			const pi_flt QabaM = 10939058860032000.0;
-			res.Pab = (6.0 * a - 5.0) * (2.0 * a - 1.0) * (6.0 * a - 1.0);
-			res.Qab = a * a * a * QabaM;
+int save_cancelled(const char *path, uint64_t terms, const bs_result *res) {
+	printf("Cancelled by signal %d. ", (int)pidef_cancel_signal);
+	pidef_writer checkpoint;
+	if (!pidef_writer_open(&checkpoint, path)) {
+		printf("Could not open checkpoint file \"%s\".\n", path);
+		return 128 + pidef_cancel_signal;
+	}
+
+	if (res) bs_checkpoint_write(&checkpoint, BS_PI, terms, res);
+	else bs_checkpoint_write_saved(&checkpoint, BS_PI, terms);
+	if (!pidef_writer_close(&checkpoint)) printf("Could not write checkpoint \"%s\".\n", path);
+	else printf("Saved %" PRIu64 " of %" PRIu64 " terms of the series to \"%s\", continue with --resume %s\n",
+		res ? terms : bs_saved_terms(), terms, path, path);
+	return 128 + pidef_cancel_signal;
+}
+
+void start_series_progress(int show_progress, uint64_t terms) {
+	if (!show_progress) return;
+	pidef_progress_start(&series_progress, "Series", "terms merged", bs_progress_total(terms), PIDEF_PROGRESS_INTERVAL);
+	bs_progress = &series_progress;
+}
+
+void stop_series_progress(void) {
+	if (!bs_progress) return;
+	pidef_progress_stop(bs_progress);
+	bs_progress = NULL;
+}
+
+char *other_backend_pi_str(int backend, long digits, long calc_digits, uint64_t terms, int num_threads, double stage_ends[3]) {
+	char *pi_str = NULL;
+	if (backend == BACKEND_DECIMAL) {
+		/* Fixed point with 'prec' limbs of 9 digits after the point. */
+		const size_t prec = (size_t)calc_digits / DN_LIMB_DIGITS + 2;
+		bs_dec_result res;
+		bs_dec_split(&bs_builtin_series[BS_PI], 0, terms, &res, num_threads);
+		stop_series_progress();
+		stage_ends[0] = pidef_wall_seconds();
+		pidef_memory_phase_next("finish");
+
+		decint pi;
+		decint_init(&pi);
+		bs_dec_finish_pi(&pi, &res, prec);
+		stage_ends[1] = pidef_wall_seconds();
+		pidef_memory_phase_next("conversion");
+
+		pi_str = bs_dec_fixed_to_str(&pi, prec, digits);
+		bs_dec_result_free(&res);
+		decint_free(&pi);
+	}
+
+	#ifdef PI_HAVE_GMP
+	if (backend == BACKEND_GMP) {
+		bs_gmp_result res;
+		bs_gmp_split(&bs_builtin_series[BS_PI], 0, terms, &res, num_threads);
+		stop_series_progress();
+		stage_ends[0] = pidef_wall_seconds();
+		pidef_memory_phase_next("finish");
+
+		/*
+		   The guard digits are calculated exactly, then divided off before the conversion, so the string
+		   keeps the strlen + 1 bytes that GMP allocated it with when it is freed.
+		*/
+		mpz_t pi, guard;
+		mpz_init(pi);
+		mpz_init(guard);
+		bs_gmp_finish_pi(pi, &res, calc_digits);
+		mpz_ui_pow_ui(guard, 10, (unsigned long)(calc_digits - digits));
+		mpz_tdiv_q(pi, pi, guard);
+		stage_ends[1] = pidef_wall_seconds();
+		pidef_memory_phase_next("conversion");
+
+		pi_str = mpz_get_str(NULL, 10, pi);
+		bs_gmp_result_free(&res);
+		mpz_clear(pi);
+		mpz_clear(guard);
+	}
+	#endif
+
+	stage_ends[2] = pidef_wall_seconds();
+	pidef_memory_phase_next(NULL);
+	return pi_str;
+}
+
+void other_backend_free_str(int backend, char *pi_str) {
+	#ifdef PI_HAVE_GMP
+	if (backend == BACKEND_GMP) {
+		void (*gmp_free)(void *, size_t);
+		mp_get_memory_functions(NULL, NULL, &gmp_free);
+		gmp_free(pi_str, strlen(pi_str) + 1);
+		return;
+	}
+	#else
+	(void)backend;
+	#endif
+	free(pi_str);
+}
+
+int other_backend_pi(int backend, long digits, long calc_digits, uint64_t terms, int num_threads, const char *output_path,
+	clock_t start_time, double wall_start)
+{
+	double stage_ends[3];
+	char *const pi_str = other_backend_pi_str(backend, digits, calc_digits, terms, num_threads, stage_ends);
+	const clock_t end_time = clock();
+	pidef_energy_stop(&energy);
+	printf("Backend: %s\n", backend_names[backend]);
+
+	pidef_writer output;
+	if (output_path) {
+		if (!pidef_writer_open(&output, output_path)) {
+			fprintf(stderr, "Could not open output file \"%s\".\n", output_path);
+			return EXIT_FAILURE;
 		}
+		pidef_writer_write(&output, pi_str, strlen(pi_str));
+		pidef_writer_write(&output, "\n", 1);
+		printf("Pi approximation: written to \"%s\"\nTime taken: %fs\n", output_path, (double)(end_time - start_time) / CLOCKS_PER_SEC);
+	} else printf("Pi approximation: %s\nTime taken: %fs\n", pi_str, (double)(end_time - start_time) / CLOCKS_PER_SEC);
 
-		res.Tab = res.Pab * ((545140134.0 * a) + 13591409.0);
-		res.Tab = a & 1 ? -res.Tab : res.Tab;
-		return res;
-	} else {
-		const pi_uint m = (a + b) / (pi_uint)(2U);
-		const result_flts am = chudnovsky_binarysplit(a, m);
-		const result_flts mb = chudnovsky_binarysplit(m, b);
+	pidef_energy_print(&energy, (double)digits, "digits");
+	pidef_memory_print();
+	printf("Stages: %fs series, %fs finish, %fs conversion to decimal (wall time)\n",
+		stage_ends[0] - wall_start, stage_ends[1] - stage_ends[0], stage_ends[2] - stage_ends[1]);
 
-		res.Pab = am.Pab * mb.Pab;
-		res.Qab = am.Qab * mb.Qab;
-		res.Tab = mb.Qab * am.Tab + am.Pab * mb.Tab;
+	int write_failed = 0;
+	if (output_path) {
+		write_failed = !pidef_writer_close(&output);
+		pidef_writer_print_stats(&output, "Output");
 	}
-	
-	return res;
+
+	other_backend_free_str(backend, pi_str);
+	bn_ntt_cache_free();
+
+	if (write_failed) {
+		fprintf(stderr, "Could not write all output.\n");
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
 }
@@ -0,0 +1,113 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Calculates other well-known constants to any number of digits with the same binary splitting
+   engine used by the Chudnovsky pi program (see c_binsplit.h). Each constant is a hypergeometric
+   series, so only the polynomials of the series and how its sum becomes the constant differ.
+
+   See the following articles for more information:
+   https://en.wikipedia.org/wiki/E_(mathematical_constant)
+   https://en.wikipedia.org/wiki/Natural_logarithm_of_2
+   https://en.wikipedia.org/wiki/Ap%C3%A9ry%27s_constant
+   https://en.wikipedia.org/wiki/Catalan%27s_constant
+   https://en.wikipedia.org/wiki/Square_root_of_2
+*/
+
+/* Required includes. */
+#include "c_binsplit.h"
+#include "c_bench.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+/* Number of extra digits calculated to avoid rounding errors in the last digits. */
+#define GUARD_DIGITS 10
+
+/* Prints the integer string of a constant multiplied by 10^digits with a decimal point. */
+void print_fixed_decimal(const char *str, long digits);
+
+int main(int argc, char *argv[]) {
+	/* Check for correct argument count. */
+	if (argc < 3 || argc > 4) {
+		fprintf(stderr, "Usage: %s constant_choice digits [num_threads]\nChoices:\n", *argv);
+		for (int i = 0; i < BS_SERIES_COUNT; ++i) printf("  %d - %s\n", i + 1, bs_builtin_series[i].name);
+		return EXIT_FAILURE;
+	}
+
+	/* Get and validate the constant choice. */
+	const long choice = strtol(argv[1], NULL, 10);
+	if (choice < 1 || choice > BS_SERIES_COUNT) {
+		fprintf(stderr, "Invalid constant option.\n");
+		return EXIT_FAILURE;
+	}
+
+	/* Get and validate digits accuracy and the optional thread count. */
+	const long digits = strtol(argv[2], NULL, 10);
+	const int num_threads = argc == 4 ? atoi(argv[3]) : 1;
+
+	if (digits <= 0) {
+		fprintf(stderr, "Digits count must be larger than 0.\n");
+		return EXIT_FAILURE;
+	}
+
+	if (num_threads <= 0) {
+		fprintf(stderr, "Thread count must be larger than 0.\n");
+		return EXIT_FAILURE;
+	}
+
+	const bs_series *const series = &bs_builtin_series[choice - 1];
+	printf("Constant: %s\n", series->name);
+
+	/* Start timer and energy measurement. */
+	const clock_t start_time = clock();
+	pidef_energy energy;
+	pidef_energy_start(&energy);
+
+	/* Calculate the series and turn the result into the constant, multiplied by 10^digits. */
+	const long calc_digits = digits + GUARD_DIGITS;
+	const uint64_t terms = bs_terms_needed(series, calc_digits);
+	const size_t prec = (size_t)((double)calc_digits * 3.321928094887362 / BN_LIMB_BITS) + 2;
+
+	/* Any part of the finish that does not depend on the series is calculated at the same time as it. */
+	bs_prepare_task prepare_task;
+	bs_prepare_start(&prepare_task, series, prec);
+
+	bs_result res;
+	bigint value;
+	bigint_init(&value);
+	bs_split(series, 0, terms, &res, num_threads, prec + BS_TRUNCATE_GUARD);
+	bs_prepare_join(&prepare_task);
+	series->finish(&value, &res, &prepare_task.value, prec);
+	bs_fixed_to_decimal(&value, &value, prec, digits);
+
+	/* End timer. */
+	const clock_t end_time = clock();
+
+	char *const value_str = bigint_get_str(&value);
+	pidef_energy_stop(&energy);
+	printf("Terms: %" PRIu64 "\nApproximation: ", terms);
+	print_fixed_decimal(value_str, digits);
+	printf("\nTime taken: %fs\n", (double)(end_time - start_time) / CLOCKS_PER_SEC);
+	pidef_energy_print(&energy, (double)digits, "digits");
+
+	free(value_str);
+	bs_result_free(&res);
+	bigint_free(&prepare_task.value);
+	bigint_free(&value);
+	return EXIT_SUCCESS;
+}
+
+void print_fixed_decimal(const char *str, long digits) {
+	const long length = (long)strlen(str);
+
+	/* Integer part, which is 0 if there are no more digits than the fractional part. */
+	if (length > digits) fwrite(str, 1, (size_t)(length - digits), stdout);
+	else putchar('0');
+	putchar('.');
+
+	/* Fractional part, including any leading zeros not in the string. */
+	for (long i = length; i < digits; ++i) putchar('0');
+	fputs(length > digits ? str + length - digits : str, stdout);
+}
@@ -8,22 +8,38 @@
 
    Infinite sums do so using addition whereas infinite products use multiplication.
 
+   Term counts are 64-bit, and each series runs in chunks of terms that continue from the state the
+   previous chunk left, so very long runs (such as 10^12 terms) report their progress between chunks.
+   Ctrl-C or SIGTERM stops each series after its current chunk, printing its partial result.
+
+   With --autotune, all series are shared by the number and placement of threads that the autotuner
+   (see c_tune.h) measured as the fastest on this host, instead of one unpinned thread per series.
+
    See https://en.wikipedia.org/wiki/Pi#Infinite_series for more information.
 */
 
 /* Required includes. */
-#include "c_threads.h" 
+#include "c_tune.h"
+#include "c_series.h"
+#include "c_progress.h"
+#include "c_bench.h"
+#include "c_memory.h"
+#include <inttypes.h>
+#include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <time.h>
-#include <math.h>
 
-/* Types to use for storing calculations. */
-typedef long terms_t; /* Loops counter type. */
-typedef double pi_res_t; /* Calculation type. Preferably a floating point type. */
+/* Number of terms calculated at a time, between progress updates. */
+#define CHUNK_TERMS ((terms_t)1 << 24)
+
+static pidef_progress *terms_progress; /* Progress of the terms, or NULL if it is not reported. */
+static terms_t terms_done; /* Terms calculated by all series, for the energy report. */
 
-/* Shortcut for do..while loop with 'terms' counter. */
-#define LOOP_TERMS(expr) do expr while(--terms)
+/* Index of the next series for a worker thread to calculate, and the tuned placement of workers, or NULL if not autotuned. */
+static int next_series;
+static const pidef_tune_result *worker_placement;
+static volatile pi_res_t tune_sink; /* Keeps the series of the autotuner from being optimized out. */
 
 
 /*
@@ -33,49 +49,24 @@ typedef double pi_res_t; /* Calculation type. Preferably a floating point type.
 /* 
    Do a single pi calculation using the function correlation to the given index,
    printing out the result and the time taken to execute.
-   Takes in the function index and the number of terms to calculate (aka accuracy).
+   Takes in the function index and the number of terms to calculate (aka accuracy),
+   which are calculated in chunks of CHUNK_TERMS.
 */
-void do_series(int series_index, int given_terms_count);
+void do_series(int series_index, terms_t given_terms_count);
 
 /* 
-   Same as do_series, but in a threading context.
-   Takes in a pointer to a thread_series_data object, which is freed.
+   Worker thread for calculating all series, which calls do_series for each series not yet taken by another worker.
+   Takes in a pointer to the worker's index and the number of terms, used to pin it when autotuned.
    Returns NULL for threading purposes.
 */
-thread_func_t do_series_thread(thread_arg_t data);
+thread_func_t series_worker_thread(thread_arg_t data);
+
+/* Autotuner work: calculates 'units' terms of a series, a different one for each thread index. */
+void tune_series(int index, uint64_t units);
 
 /* Prints the given number with a comma for a thousands separator to stdout. */
 void print_thousands_sepd_num(terms_t terms);
 
-/*
-   Infinite series functions declarations.
-   All take in the number of terms (loop count).
-*/
-
-/* https://en.wikipedia.org/wiki/Wallis_product */
-pi_res_t wallis_product(terms_t terms);
-
-/* https://en.wikipedia.org/wiki/Vi%C3%A8te%27s_formula */
-pi_res_t vietes_formula(terms_t terms);
-
-/* https://en.wikipedia.org/wiki/Pi#cite_ref-FOOTNOTEArndtHaenel2006Formula_16.10,_p._223_78-0 */
-pi_res_t nilakantha(terms_t terms);
-
-/* 
-   https://en.wikipedia.org/wiki/Arctangent_series
-   https://en.wikipedia.org/wiki/Leibniz_formula_for_%CF%80
-   Calculates 4 arctan(1). Newton's version converges much faster than this.
-   The generalized formula of this for any arctan x is known as the Gregory series.
-*/
-pi_res_t madhava_leibniz_formula(terms_t terms);
-
-/* 
-   https://en.wikipedia.org/wiki/Pi#cite_ref-70
-   Infinite series to calculate 4 arctan(1).
-   Note that arctan 1 = pi/4.
-*/
-pi_res_t newton_arctan_pi(terms_t terms);
-
 
 /*
    Struct definitions.
@@ -83,34 +74,24 @@ pi_res_t newton_arctan_pi(terms_t terms);
 
 /* Data struct for pi calculation in separate threads. */
 typedef struct {
-	int series_index;
+	int worker_index;
 	terms_t terms_count;
 } thread_series_data;
 
-/* Storage of functions and name for printing */
-typedef struct {
-	pi_res_t (*address)(terms_t terms);
-	const char *given_name;
-} series_func_data;
-
-/* All calculation functions and names for display */
-static series_func_data series_function_data[] = {
-	{ wallis_product, "Wallis product" },
-	{ vietes_formula, "Viete's formula" },
-	{ nilakantha, "Nilakantha series" },
-	{ madhava_leibniz_formula, "Madhava-Leibniz formula (arctan)" },
-	{ newton_arctan_pi, "Newton series (arctan)" }
-};
-
 
 int main(int argc, char *argv[]) {
-	/* Number of elements in series functions data list. */
-	const int count_series_functions = (int)(sizeof series_function_data / sizeof *series_function_data);
-
 	/* Check for correct argument count. */
-	if (argc != 3) {
-		fprintf(stderr, "Usage: %s series_choice series_terms\nChoices:\nall - All below series\n", *argv);
-		for (int i = 0; i < count_series_functions; ++i) printf("  %d - %s\n", i + 1, series_function_data[i].given_name);
+	int show_progress = 0, autotune = 0, retune = 0, track_memory = 0;
+	for (int i = 3; i < argc; ++i) {
+		if (!strcmp(argv[i], "--progress")) show_progress = 1;
+		else if (!strcmp(argv[i], "--memory")) track_memory = 1;
+		else if (!strcmp(argv[i], "--autotune")) autotune = 1;
+		else if (!strcmp(argv[i], "--retune")) autotune = retune = 1;
+		else argc = 0;
+	}
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s series_choice series_terms [--progress] [--autotune] [--retune] [--memory]\nChoices:\nall - All below series\n", *argv);
+		for (int i = 0; i < SERIES_COUNT; ++i) printf("  %d - %s\n", i + 1, series_function_data[i].given_name);
 		return EXIT_FAILURE;
 	}
 
@@ -119,16 +100,21 @@ int main(int argc, char *argv[]) {
 	const pi_i64 given_series_value = is_all_series ? -1 : strtol(argv[1], NULL, 10);
 
 	/* Check for a valid range of the possibly given function index. */
-	if (!is_all_series && (given_series_value < 1 || given_series_value > count_series_functions)) {
+	if (!is_all_series && (given_series_value < 1 || given_series_value > SERIES_COUNT)) {
 		fprintf(stderr, "Invalid series option.\n");
 		return EXIT_FAILURE;
 	}
+	if (!is_all_series && autotune) {
+		fprintf(stderr, "Autotuning only applies to all series.\n");
+		return EXIT_FAILURE;
+	}
 
 	/* Get the number of terms (times to loop) from the given 3rd argument. */
-	const terms_t given_terms_count = strtol(argv[2], NULL, 10);
+	const long long parsed_terms_count = strtoll(argv[2], NULL, 10);
+	const terms_t given_terms_count = parsed_terms_count > 0 ? (terms_t)parsed_terms_count : 0;
 	
 	/* Check for term value validity. */
-	if (given_terms_count <= 0) {
+	if (parsed_terms_count <= 0) {
 		fprintf(stderr, "Terms value must be larger than 0.\n");
 		return EXIT_FAILURE;
 	}
@@ -138,69 +124,59 @@ int main(int argc, char *argv[]) {
 	print_thousands_sepd_num(given_terms_count);
 	printf("\nChosen series: %s\n", is_all_series ? "All" : series_function_data[given_series_value - 1].given_name);
 
-	if (!is_all_series) {
-		do_series(given_series_value - 1, given_terms_count);
-		return EXIT_SUCCESS;
-	}
-	
-	thread_id_t thread_handlers[count_series_functions];
-	for (int i = 0; i < count_series_functions; ++i) {
-		thread_series_data *const current_data = (thread_series_data*)malloc(sizeof(thread_series_data));
-		if (!current_data) {
-			fprintf(stderr, "Could not allocate memory for series \"%s\". Skipping.", series_function_data[i].given_name);
-			continue;
-		}
-		
-		current_data->series_index = i;
-		current_data->terms_count = given_terms_count;
-		pidef_create_thread(thread_handlers + i, do_series_thread, current_data);
+	/* Share the series between the fastest number and placement of threads for this host, or use one thread per series. */
+	int worker_count = SERIES_COUNT;
+	pidef_tune_result placement;
+	if (autotune) {
+		pidef_tune("pi_infseries", "terms", tune_series, SERIES_COUNT, retune, &placement);
+		worker_count = placement.threads;
+		worker_placement = &placement;
 	}
 
-	for (int i = 0; i < count_series_functions; ++i) pidef_join_thread(thread_handlers[i]);
-	return EXIT_SUCCESS;
-}
+	/* Stop early and print the partial results when cancelled. */
+	pidef_cancel_install();
 
+	/* Optionally report the progress of all series' terms to stderr. */
+	pidef_progress progress;
+	if (show_progress) {
+		pidef_progress_start(&progress, "Terms", "terms", given_terms_count * (terms_t)(is_all_series ? SERIES_COUNT : 1),
+			PIDEF_PROGRESS_INTERVAL);
+		terms_progress = &progress;
+	}
 
-/*
-   Infinite series functions definitions.
-*/
-
-pi_res_t wallis_product(terms_t terms) {
-	pi_res_t res = 1.0, top = 0.0, bottom = 1.0;
-	LOOP_TERMS({
-		top += 2.0;
-		res *= (top / bottom);
-		bottom += 2.0;
-		res *= (top / bottom);
-	});
-	return res * 2.0;
-}
-
-pi_res_t vietes_formula(terms_t terms) {
-	pi_res_t res = 1.0, sqr_res = 0.0;
-	LOOP_TERMS( res *= 2.0 / (sqr_res = sqrt(2.0 + sqr_res)); );
-	return res * 2.0;
-}
+	/* Measure the energy (and optionally memory) used by all series together, as they run at the same time. */
+	if (track_memory) pidef_memory_start("series");
+	pidef_energy energy;
+	pidef_energy_start(&energy);
+
+	if (!is_all_series) do_series(given_series_value - 1, given_terms_count);
+	else {
+		/* Only the created workers are joined, as the others share the same series between them. */
+		thread_id_t thread_handlers[worker_count];
+		int created_count = 0;
+		for (int i = 0; i < worker_count; ++i) {
+			thread_series_data *const current_data = (thread_series_data*)pidef_malloc(sizeof(thread_series_data));
+			if (!current_data) {
+				fprintf(stderr, "Could not allocate memory for worker %d. Skipping.\n", i);
+				continue;
+			}
+
+			current_data->worker_index = i;
+			current_data->terms_count = given_terms_count;
+			pidef_create_thread(thread_handlers + created_count++, series_worker_thread, current_data);
+		}
 
-pi_res_t nilakantha(terms_t terms) {
-	pi_res_t res = 3.0, denom_cnt = 2.0, sign = -1.0, denom = 0.0;
-	LOOP_TERMS({
-		denom = denom_cnt * (denom_cnt + 1.0);
-		res += (4.0 / (denom *= (denom_cnt += 2.0))) * (sign = -sign); 
-	});
-	return res;
-}
+		for (int i = 0; i < created_count; ++i) pidef_join_thread(thread_handlers[i]);
 
-pi_res_t madhava_leibniz_formula(terms_t terms) {
-	pi_res_t res = 1.0, sign = 1.0, denom = 1.0;
-	LOOP_TERMS( res += (1.0 / (denom += 2.0)) * (sign = -sign); );
-	return res * 4.0;
-}
+		/* Without any workers, the main thread calculates the series itself. */
+		if (!created_count) for (int i; (i = pidef_atomic_inc_int(&next_series)) < SERIES_COUNT;) do_series(i, given_terms_count);
+	}
 
-pi_res_t newton_arctan_pi(terms_t terms) {
-	pi_res_t res = 0.5, fract_num = 0.0, fract_den = 1.0, fract_tot = 1.0, den_mult = 2.0;
-	LOOP_TERMS( res += (1.0 / (den_mult *= 2.0)) * (fract_tot *= ((fract_num += 2.0) / (fract_den += 2.0))); );
-	return res * 4.0;
+	pidef_energy_stop(&energy);
+	if (terms_progress) pidef_progress_stop(terms_progress);
+	pidef_energy_print(&energy, (double)terms_done, "terms");
+	pidef_memory_print();
+	return pidef_cancel_signal ? 128 + pidef_cancel_signal : EXIT_SUCCESS;
 }
 
 
@@ -208,29 +184,50 @@ pi_res_t newton_arctan_pi(terms_t terms) {
    Execution functions definitions.
 */
 
-void do_series(int series_index, int given_terms_count) {
+void do_series(int series_index, terms_t given_terms_count) {
 	/* Get the specific calculation function from the given index. */
 	const series_func_data current_series = series_function_data[series_index];
 
-	/* Time calculating pi with specific function. */
+	/* Time calculating pi with specific function, continuing the series' state chunk by chunk. */
 	const clock_t start_time = clock();
-	const pi_res_t res = current_series.address(given_terms_count);
+	series_state state = current_series.initial;
+	terms_t done = 0;
+	while (done < given_terms_count && !pidef_cancel_signal) {
+		const terms_t chunk = given_terms_count - done < CHUNK_TERMS ? given_terms_count - done : CHUNK_TERMS;
+		current_series.address(&state, chunk);
+		done += chunk;
+		pidef_progress_add(terms_progress, chunk);
+	}
+	pidef_atomic_add(&terms_done, done);
+	const pi_res_t res = state.res * current_series.multiplier;
 	const clock_t end_time = clock();
 
-	/* Print result of specific function and the time it took in seconds. */
-	printf("%s result: %f (%fs)\n", current_series.given_name, res, (double)(end_time - start_time) / CLOCKS_PER_SEC);
+	/* Print result of specific function and the time it took in seconds, and the terms used if it was cancelled. */
+	printf("%s result: %f (%fs)", current_series.given_name, res, (double)(end_time - start_time) / CLOCKS_PER_SEC);
+	if (done < given_terms_count) printf(" - cancelled after %" PRIu64 " of %" PRIu64 " terms", done, given_terms_count);
+	putchar('\n');
 }
 
-thread_func_t do_series_thread(thread_arg_t data) {
+thread_func_t series_worker_thread(thread_arg_t data) {
 	thread_series_data given_data = *(thread_series_data*)(data); /* Cast data from main thread to proper type. */
-	free(data); /* Given pointer is created with malloc. */
-	do_series(given_data.series_index, given_data.terms_count); /* Calculate and print results. */
+	pidef_free(data); /* Given pointer is created with pidef_malloc. */
+	if (worker_placement) pidef_tune_pin(worker_placement, given_data.worker_index);
+
+	/* Calculate and print the results of series until none are left. */
+	for (int i; (i = pidef_atomic_inc_int(&next_series)) < SERIES_COUNT;) do_series(i, given_data.terms_count);
 	return NULL; /* Threading functions return a void pointer. Not used in this case, so it can be left as NULL. */
 }
 
+void tune_series(int index, uint64_t units) {
+	const series_func_data current_series = series_function_data[index % SERIES_COUNT];
+	series_state state = current_series.initial;
+	current_series.address(&state, units);
+	tune_sink = state.res;
+}
+
 void print_thousands_sepd_num(terms_t terms) {
 	if (terms >= 1000) {
 		print_thousands_sepd_num(terms / 1000); /* Recursion to advance through number. */
-		printf(",%03ld", terms % 1000); /* Print next 3 digits */
-	} else printf("%ld", terms); /* Print whole number if it is less than 1k, no separator needed*/
+		printf(",%03" PRIu64, terms % 1000); /* Print next 3 digits */
+	} else printf("%" PRIu64, terms); /* Print whole number if it is less than 1k, no separator needed*/
 }
@@ -11,6 +11,16 @@
    it only involves generating random points and calculating their length and an overall ratio,
    with no dependency on previous iterations.
 
+   Giving 'auto' as the number of threads uses the number and placement of threads that the autotuner
+   (see c_tune.h) measured as the fastest on this host, sweeping them first if they are not cached yet.
+
+   The random numbers come from the generator given with --rng (see c_random.h), the original LCG by default.
+   Giving only --rngs measures the points per second of each generator and runs a quick statistical check of it,
+   to choose between speed and quality knowingly.
+
+   Ctrl-C or SIGTERM stops all threads at their next batch of points, and the estimate of the points
+   generated so far is printed.
+
    However, it is hopelessly inaccurate, only allowing calculations of a very few digits of pi even
    as the number of iterations is heavily increased.
    
@@ -22,23 +32,46 @@
 */
 
 /* Required includes. */
-#include "c_threads.h"
+#include "c_tune.h"
+#include "c_mcarlo.h"
+#include "c_progress.h"
+#include "c_bench.h"
+#include "c_memory.h"
 #include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <time.h>
+#include <math.h>
 
-typedef uint_least64_t counter_t; /* Int type to store the number of 'points' during calculation. */
 static counter_t num_iterations; /* Run-time value of the number of points. */
 
+/* Points generated between progress updates, keeping the updates out of the inner loop. */
+#define PROGRESS_BATCH ((counter_t)1 << 20)
+
+/* Most threads, beyond which more would only add overhead. */
+#define MAX_THREADS 1024
+static pidef_progress *points_progress; /* Progress of the points, or NULL if it is not reported. */
+
+/* Results of all threads, and the tuned placement that threads are pinned with, or NULL if not autotuned. */
+static counter_t (*all_results)[2];
+static const pidef_tune_result *thread_placement;
+static volatile counter_t tune_sink; /* Keeps the points of the autotuner from being optimized out. */
+
+/* Generator of the points, and the points and seconds used by each to measure their speed with --rngs. */
+static int rng_kind = PIDEF_RNG_LCG;
+#define RNG_CHECK_SAMPLES ((uint64_t)1 << 24)
+#define RNG_SPEED_SECONDS 0.25
+
 /*
    Function declarations.
 */
 
-/* Returns a 'pseudo-random' decimal in the range [0, 1] using the provided seed.
-   Modifies the seed for the next call. */
-float fastrand01(unsigned *seed);
+/* Autotuner work: generates 'units' points in the same way as the threads of a calculation. */
+void tune_points(int index, uint64_t units);
+
+/* Prints the speed and statistical check of each generator. */
+void compare_rngs(void);
 
 /* 
    Generates 'num_iterations' random points on a unit square to determine how
@@ -55,74 +88,173 @@ thread_func_t approximate_pi_mcarlo(thread_arg_t results_array);
 
 int main(int argc, char *argv[]) {
 	/* Check for the correct number of arguments. */
-	if (argc != 3) {
-		fprintf(stderr, "Usage: %s points_per_thread num_threads\n", *argv);
+	if (argc == 2 && !strcmp(argv[1], "--rngs")) {
+		compare_rngs();
+		return EXIT_SUCCESS;
+	}
+
+	int show_progress = 0, retune = 0, track_memory = 0;
+	for (int i = 3; i < argc; ++i) {
+		if (!strcmp(argv[i], "--progress")) show_progress = 1;
+		else if (!strcmp(argv[i], "--retune")) retune = 1;
+		else if (!strcmp(argv[i], "--memory")) track_memory = 1;
+		else if (!strcmp(argv[i], "--rng") && i + 1 < argc && (rng_kind = pidef_rng_find(argv[++i])) >= 0) continue;
+		else argc = 0;
+	}
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s points_per_thread num_threads|auto [--progress] [--retune] [--memory] [--rng name]\n"
+			"       %s --rngs\nGenerators:", *argv, *argv);
+		for (int i = 0; i < PIDEF_RNG_COUNT; ++i) fprintf(stderr, " %s", pidef_rng_names[i]);
+		fputc('\n', stderr);
 		return EXIT_FAILURE;
 	}
 
 	num_iterations = strtoul(argv[1], NULL, 10);
-	const long num_threads = strtol(argv[2], NULL, 10);
+	long num_threads = strtol(argv[2], NULL, 10);
+
+	/* Use the fastest number and placement of threads for this host. */
+	pidef_tune_result placement;
+	if (!strcmp(argv[2], "auto")) {
+		pidef_tune("pi_mcarlo", "points", tune_points, 0, retune, &placement);
+		num_threads = placement.threads;
+		thread_placement = &placement;
+	}
+	if (num_threads < 1) {
+		fprintf(stderr, "Number of threads must be at least 1.\n");
+		return EXIT_FAILURE;
+	}
+	if (num_threads > MAX_THREADS) num_threads = MAX_THREADS;
 
-	counter_t thread_results[num_threads][2]; /* Create empty 'results' arrays for each thread to work on. */
-	memset(thread_results, 0, sizeof(thread_results));
+	/* Create empty 'results' arrays for each thread to work on, and the IDs of all threads but the main one. */
+	counter_t (*const thread_results)[2] = calloc((size_t)num_threads, sizeof *thread_results);
+	thread_id_t *const threads = malloc((size_t)num_threads * sizeof *threads);
+	if (!thread_results || !threads) {
+		fprintf(stderr, "Could not allocate memory for %ld threads.\n", num_threads);
+		free(thread_results);
+		free(threads);
+		return EXIT_FAILURE;
+	}
+	all_results = thread_results;
 	
-	/* Begin timing. */
+	/* Begin timing, energy measurement and optionally counting memory. */
+	if (track_memory) pidef_memory_start("points");
 	const clock_t start_time = clock();
+	pidef_energy energy;
+	pidef_energy_start(&energy);
+
+	/* Stop early and print the estimate so far when cancelled. */
+	pidef_cancel_install();
+
+	/* Optionally report the progress of all threads' points to stderr. */
+	pidef_progress progress;
+	if (show_progress) {
+		pidef_progress_start(&progress, "Points", "points", num_iterations * (counter_t)num_threads, PIDEF_PROGRESS_INTERVAL);
+		points_progress = &progress;
+	}
 
 	/* Create all of the other threads to work on their own section of the result arrays. */
-	#if num_threads > 1
-	thread_id_t threads[num_threads - 1];
 	for (int i = 0; i < num_threads - 1; ++i) pidef_create_thread(&threads[i], approximate_pi_mcarlo, thread_results[i]);
-	#endif
 	
 	/* Make the main thread also calculate instead of slouching around. */
 	counter_t *local_results = thread_results[num_threads - 1]; /* Using last results counters. */
 	approximate_pi_mcarlo(local_results);
 
 	/* Wait for all other threads to finish. */
-	#if num_threads > 1
 	for (int i = 0; i < num_threads - 1; ++i) pidef_join_thread(threads[i]);
+	if (points_progress) pidef_progress_stop(points_progress);
 
 	/* Combine all of the results into the main thread's counters. */
 	for (int i = 0; i < num_threads - 1; ++i) {
 		local_results[0] += thread_results[i][0];
 		local_results[1] += thread_results[i][1];
 	}
-	#endif
 
 	/* End timing. */
 	const clock_t end_time = clock();
+	pidef_energy_stop(&energy);
 
 	/* Print overall counters results and pi from points ratio. */
+	if (pidef_cancel_signal) {
+		printf("Cancelled by signal %d after %" PRIuLEAST64 " of %" PRIuLEAST64 " points\n", (int)pidef_cancel_signal,
+			local_results[0] + local_results[1], num_iterations * (counter_t)num_threads);
+	}
 	printf("Points results:\n  %lu inside\n  %lu outside\nPi approximation: %f\nTime taken: %fs\n",
 		local_results[1], local_results[0],
 		(4.0 * (double)local_results[1]) / (double)(local_results[0] + local_results[1]),
 		(double)(end_time - start_time) / CLOCKS_PER_SEC
 	);
+	pidef_energy_print(&energy, (double)(local_results[0] + local_results[1]), "points");
+	pidef_memory_print();
 
-	return 0;
+	free(thread_results);
+	free(threads);
+	return pidef_cancel_signal ? 128 + pidef_cancel_signal : 0;
 }
 
 /*
    Function definitions.
 */
 
-float fastrand01(unsigned *seed) { return (float)( (*seed = 3812762923u * (*seed)) & RAND_MAX) / (float)RAND_MAX; }
-
 thread_func_t approximate_pi_mcarlo(thread_arg_t results_array) {
 	/* Cast given void pointer into a counter_t integer pointer type. */
 	counter_t *counter_arrays = (counter_t*)results_array;
 	
-	/* Create a local seed value using normal 'rand' and time functions. */
-	unsigned seed = (rand() + 214584u) * time(NULL);
-
-	for (counter_t i = 0; i < num_iterations; ++i) {
-		/* Get a pseudo-random X and Y position, each in the range [0, 1]. */
-		const float randX = fastrand01(&seed), randY = fastrand01(&seed);
-		/* The point is 'inside' the 'circle' if the coordinate sqr. length (X^2 + Y^2) is less than 1.
-		   'Use conditional result (<1.0 = 1 else 0) for indexes into pointer. */
-		++counter_arrays[(randX * randX) + (randY * randY) < 1.0];
+	/* Pin the thread as the autotuner measured, using its index into the results. */
+	if (thread_placement) pidef_tune_pin(thread_placement, (int)((counter_t(*)[2])results_array - all_results));
+
+	/* Seed the generator using normal 'rand' and time functions. */
+	pidef_rng rng;
+	pidef_rng_seed(&rng, rng_kind, (uint64_t)(rand() + 214584u) * (uint64_t)time(NULL));
+
+	for (counter_t done = 0; done < num_iterations && !pidef_cancel_signal;) {
+		const counter_t batch = num_iterations - done < PROGRESS_BATCH ? num_iterations - done : PROGRESS_BATCH;
+		generate_points(counter_arrays, batch, &rng);
+		done += batch;
+		pidef_progress_add(points_progress, batch);
 	}
 
 	return NULL;
 }
+
+void tune_points(int index, uint64_t units) {
+	counter_t counters[2] = { 0, 0 };
+	pidef_rng rng;
+	pidef_rng_seed(&rng, rng_kind, 214584u + (unsigned)index);
+	generate_points(counters, units, &rng);
+	tune_sink = counters[1];
+}
+
+void compare_rngs(void) {
+	printf("Generator    Points/s ");
+	for (int t = 0; t < PIDEF_RNG_TESTS; ++t) printf(" %11s", pidef_rng_test_names[t]);
+	printf("  Check (z-scores of %" PRIu64 " decimals)\n", RNG_CHECK_SAMPLES);
+
+	for (int kind = 0; kind < PIDEF_RNG_COUNT; ++kind) {
+		/* Generate batches of points until the time is up, as the Monte Carlo threads do. */
+		counter_t counters[2] = { 0, 0 };
+		pidef_rng rng;
+		pidef_rng_seed(&rng, kind, 214584u);
+		const double start_time = pidef_wall_seconds();
+		double seconds;
+		do {
+			generate_points(counters, PROGRESS_BATCH, &rng);
+			seconds = pidef_wall_seconds() - start_time;
+		} while (seconds < RNG_SPEED_SECONDS);
+		tune_sink = counters[1];
+
+		double z[PIDEF_RNG_TESTS];
+		const int failed = pidef_rng_check(kind, 214584u, RNG_CHECK_SAMPLES, z);
+		printf("%-9s %9.1fM ", pidef_rng_names[kind], (double)(counters[0] + counters[1]) / seconds / 1e6);
+		if (failed < 0) {
+			printf(" Could not allocate memory for the check.\n");
+			continue;
+		}
+		for (int t = 0; t < PIDEF_RNG_TESTS; ++t) printf(" %11.2f", z[t]);
+		if (!failed) printf("  passed\n");
+		else {
+			printf("  FAILED:");
+			for (int t = 0; t < PIDEF_RNG_TESTS; ++t) if (!(fabs(z[t]) <= PIDEF_RNG_CHECK_LIMIT)) printf(" %s", pidef_rng_test_names[t]);
+			putchar('\n');
+		}
+	}
+}
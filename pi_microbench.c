@@ -0,0 +1,404 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Microbenchmarks of the primitives the pi programs are built from, so a change in the speed of a
+   program can be traced to the operations it depends on:
+   - The random number generators of the Monte Carlo method (c_random.h).
+   - Square root and division, the latency of a dependent chain (as in vietes_formula, where each root
+     needs the previous one) and the throughput of independent ones (as in wallis_product's terms).
+   - Limb kernels of the binary (base 2^32) and decimal (base 10^9) big numbers.
+   - NTT butterflies of the forward and inverse transforms, and the modular reductions they use.
+
+   Each benchmark is calibrated to run for about the given number of seconds, and the fastest of a few
+   samples is reported in cycles per operation, counted by the timestamp counter (see c_bench.h).
+   With --json, every sample is also written to a file, which pi_benchcmp compares between two builds.
+*/
+
+/* Required includes. */
+#include "c_bignum.h"
+#include "c_decnum.h"
+#include "c_random.h"
+#include "c_bench.h"
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+/* Default seconds of each benchmark, and the default and largest number of samples it is split into. */
+#define BENCH_SECONDS 0.2
+#define BENCH_SAMPLES 5
+#define BENCH_MAX_SAMPLES 10000
+
+/* Limbs of the limb kernels and values of the transforms, small enough to stay in the L1 or L2 cache. */
+#define BENCH_LIMBS 1024
+#define BENCH_BASECASE_LIMBS 32
+#define BENCH_NTT_VALUES 4096
+
+/* Number of independent chains in the throughput benchmarks, enough to hide the latency of an operation. */
+#define BENCH_CHAINS 8
+
+/* A benchmark, which runs 'reps' repetitions and returns the number of operations done. */
+typedef struct {
+	const char *name, *op;
+	uint64_t (*run)(uint64_t reps);
+} microbench;
+
+/* Operands of the benchmarks, and results that keep the compiler from removing the work. */
+static bn_limb limbs_a[BENCH_LIMBS], limbs_b[BENCH_LIMBS], limbs_r[2 * BENCH_LIMBS];
+static dn_limb dec_a[BENCH_LIMBS], dec_r[BENCH_LIMBS];
+static uint32_t ntt_values[BENCH_NTT_VALUES], ntt_twiddles[BENCH_NTT_VALUES / 2];
+static volatile uint64_t sink;
+static volatile double float_sink;
+
+
+/*
+   Function declarations.
+*/
+
+/* Benchmarks, each returning the number of operations done in 'reps' repetitions. */
+uint64_t bench_fastrand01(uint64_t reps);
+uint64_t bench_xorshift01(uint64_t reps);
+uint64_t bench_xoshiro01(uint64_t reps);
+uint64_t bench_pcg01(uint64_t reps);
+uint64_t bench_splitmix01(uint64_t reps);
+uint64_t bench_philox01(uint64_t reps);
+uint64_t bench_libc_rand(uint64_t reps);
+uint64_t bench_sqrt_latency(uint64_t reps);
+uint64_t bench_sqrt_throughput(uint64_t reps);
+uint64_t bench_div_latency(uint64_t reps);
+uint64_t bench_div_throughput(uint64_t reps);
+uint64_t bench_bn_add_n(uint64_t reps);
+uint64_t bench_bn_addmul_1(uint64_t reps);
+uint64_t bench_bn_mul_basecase(uint64_t reps);
+uint64_t bench_dn_add_n(uint64_t reps);
+uint64_t bench_dn_addmul_1(uint64_t reps);
+uint64_t bench_ntt_forward(uint64_t reps);
+uint64_t bench_ntt_inverse(uint64_t reps);
+uint64_t bench_ntt_mulmod(uint64_t reps);
+uint64_t bench_mulmod_prime(uint64_t reps);
+uint64_t bench_mod_prime(uint64_t reps);
+
+/*
+   Runs 'count' samples of the benchmark for about 'seconds' in total, storing the TSC cycles per operation of each
+   into 'samples'. Returns the fewest cycles per operation.
+*/
+double run_microbench(const microbench *bench, double seconds, double *samples, int count);
+
+/* All benchmarks, in the order they are run. */
+static const microbench microbenches[] = {
+	{ "rng/fastrand01", "number", bench_fastrand01 },
+	{ "rng/xorshift01", "number", bench_xorshift01 },
+	{ "rng/xoshiro01", "number", bench_xoshiro01 },
+	{ "rng/pcg01", "number", bench_pcg01 },
+	{ "rng/splitmix01", "number", bench_splitmix01 },
+	{ "rng/philox01", "number", bench_philox01 },
+	{ "rng/libc-rand", "number", bench_libc_rand },
+	{ "sqrt/latency", "root", bench_sqrt_latency },
+	{ "sqrt/throughput", "root", bench_sqrt_throughput },
+	{ "div/latency", "division", bench_div_latency },
+	{ "div/throughput", "division", bench_div_throughput },
+	{ "limb/bn_add_n", "limb", bench_bn_add_n },
+	{ "limb/bn_addmul_1", "limb", bench_bn_addmul_1 },
+	{ "limb/bn_mul_basecase", "limb product", bench_bn_mul_basecase },
+	{ "limb/dn_add_n", "limb", bench_dn_add_n },
+	{ "limb/dn_addmul_1", "limb", bench_dn_addmul_1 },
+	{ "ntt/forward", "butterfly", bench_ntt_forward },
+	{ "ntt/inverse", "butterfly", bench_ntt_inverse },
+	{ "reduce/ntt_mulmod", "reduction", bench_ntt_mulmod },
+	{ "reduce/bn_mulmod_prime", "reduction", bench_mulmod_prime },
+	{ "reduce/bn_mod_prime", "limb", bench_mod_prime }
+};
+
+int main(int argc, char *argv[]) {
+	/* Check for the correct arguments: up to two positional ones, and the options. */
+	const char *filter = "", *json_path = NULL;
+	double seconds = BENCH_SECONDS;
+	int sample_count = BENCH_SAMPLES, positional = 0, valid = 1;
+	for (int i = 1; i < argc && valid; ++i) {
+		if (!strcmp(argv[i], "--json") && i + 1 < argc) json_path = argv[++i];
+		else if (!strcmp(argv[i], "--samples") && i + 1 < argc) sample_count = (int)strtol(argv[++i], NULL, 10);
+		else if (!strncmp(argv[i], "--", 2)) valid = 0;
+		else if (positional == 0) filter = argv[i], ++positional;
+		else if (positional == 1) seconds = strtod(argv[i], NULL), ++positional;
+		else valid = 0;
+	}
+	if (!valid) {
+		fprintf(stderr, "Usage: %s [name_filter] [seconds_per_benchmark] [--samples count] [--json file]\nBenchmarks:\n", *argv);
+		for (size_t i = 0; i < sizeof microbenches / sizeof *microbenches; ++i) fprintf(stderr, "  %s\n", microbenches[i].name);
+		return EXIT_FAILURE;
+	}
+	if (seconds <= 0.0 || sample_count < 1 || sample_count > BENCH_MAX_SAMPLES) {
+		fprintf(stderr, "Seconds must be larger than 0, and samples between 1 and %d.\n", BENCH_MAX_SAMPLES);
+		return EXIT_FAILURE;
+	}
+
+	FILE *json = NULL;
+	if (json_path && !(json = fopen(json_path, "w"))) {
+		fprintf(stderr, "Could not open \"%s\" for writing.\n", json_path);
+		return EXIT_FAILURE;
+	}
+	double *const samples = (double*)malloc(sizeof(double) * (size_t)sample_count);
+	if (!samples) {
+		fprintf(stderr, "Could not allocate memory for the samples.\n");
+		return EXIT_FAILURE;
+	}
+
+	/* Operands with all bits in use, so no kernel takes a shortcut for zeros. */
+	for (int i = 0; i < BENCH_LIMBS; ++i) {
+		limbs_a[i] = 0xFFFFFFFFu - (bn_limb)i * 2654435761u;
+		limbs_b[i] = (bn_limb)i * 2246822519u + 1u;
+		dec_a[i] = (dn_limb)(((uint64_t)i * 2654435761u) % DN_BASE);
+	}
+	for (int i = 0; i < BENCH_NTT_VALUES; ++i) ntt_values[i] = (uint32_t)(((uint64_t)i * 2654435761u) % bn_ntt_primes[0]);
+
+	const double hz = pidef_tsc_hz();
+	printf("Timestamp counter: %.3f GHz\n", hz * 1e-9);
+	if (json) fprintf(json, "{\n  \"program\": \"pi_microbench\",\n  \"unit\": \"cycles\",\n  \"tsc_hz\": %.6g,\n  \"benchmarks\": [", hz);
+
+	int count = 0;
+	for (size_t i = 0; i < sizeof microbenches / sizeof *microbenches; ++i) {
+		const microbench *const bench = &microbenches[i];
+		if (!strstr(bench->name, filter)) continue;
+
+		const double cycles = run_microbench(bench, seconds, samples, sample_count);
+		printf("%-24s %10.3f cycles/%s (%.3fns)\n", bench->name, cycles, bench->op, cycles / hz * 1e9);
+
+		if (json) {
+			fprintf(json, "%s\n    { \"name\": \"%s\", \"op\": \"%s\", \"samples\": [", count ? "," : "", bench->name, bench->op);
+			for (int j = 0; j < sample_count; ++j) fprintf(json, "%s%.6g", j ? ", " : "", samples[j]);
+			fprintf(json, "] }");
+		}
+		++count;
+	}
+
+	if (json) {
+		fprintf(json, "\n  ]\n}\n");
+		fclose(json);
+	}
+	free(samples);
+	bn_ntt_cache_free();
+	if (!count) {
+		fprintf(stderr, "No benchmarks match \"%s\".\n", filter);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+
+/*
+   Function definitions.
+*/
+
+double run_microbench(const microbench *bench, double seconds, double *samples, int count) {
+	/* Double the repetitions until a sample takes long enough to time precisely, then scale it to the target. */
+	const double sample_seconds = seconds / count;
+	uint64_t reps = 1;
+	double taken;
+	for (;;) {
+		const double start_time = pidef_wall_seconds();
+		bench->run(reps);
+		taken = pidef_wall_seconds() - start_time;
+		if (taken >= sample_seconds / 4.0) break;
+		reps *= 2;
+	}
+	reps = (uint64_t)((double)reps * sample_seconds / taken) + 1;
+
+	double best = 0.0;
+	for (int i = 0; i < count; ++i) {
+		const uint64_t start = pidef_tsc();
+		const uint64_t ops = bench->run(reps);
+		samples[i] = (double)(pidef_tsc() - start) / (double)ops;
+		if (!i || samples[i] < best) best = samples[i];
+	}
+	return best;
+}
+
+uint64_t bench_fastrand01(uint64_t reps) {
+	unsigned seed = 214584u;
+	float sum = 0.0f;
+	for (uint64_t i = 0; i < reps; ++i) sum += fastrand01(&seed);
+	float_sink = sum;
+	return reps;
+}
+
+uint64_t bench_xorshift01(uint64_t reps) {
+	uint64_t state = UINT64_C(0x9E3779B97F4A7C15);
+	float sum = 0.0f;
+	for (uint64_t i = 0; i < reps; ++i) sum += xorshift01(&state);
+	float_sink = sum;
+	return reps;
+}
+
+uint64_t bench_xoshiro01(uint64_t reps) {
+	pidef_rng rng;
+	pidef_rng_seed(&rng, PIDEF_RNG_XOSHIRO, 214584u);
+	float sum = 0.0f;
+	for (uint64_t i = 0; i < reps; ++i) sum += xoshiro01(rng.state.xoshiro);
+	float_sink = sum;
+	return reps;
+}
+
+uint64_t bench_pcg01(uint64_t reps) {
+	pidef_rng rng;
+	pidef_rng_seed(&rng, PIDEF_RNG_PCG64, 214584u);
+	float sum = 0.0f;
+	for (uint64_t i = 0; i < reps; ++i) sum += pcg01(&rng.state.pcg);
+	float_sink = sum;
+	return reps;
+}
+
+uint64_t bench_splitmix01(uint64_t reps) {
+	uint64_t state = 214584u;
+	float sum = 0.0f;
+	for (uint64_t i = 0; i < reps; ++i) sum += splitmix01(&state);
+	float_sink = sum;
+	return reps;
+}
+
+uint64_t bench_philox01(uint64_t reps) {
+	pidef_rng rng;
+	pidef_rng_seed(&rng, PIDEF_RNG_PHILOX, 214584u);
+	float sum = 0.0f;
+	for (uint64_t i = 0; i < reps; ++i) sum += philox01(&rng.state.philox);
+	float_sink = sum;
+	return reps;
+}
+
+uint64_t bench_libc_rand(uint64_t reps) {
+	float sum = 0.0f;
+	for (uint64_t i = 0; i < reps; ++i) sum += (float)rand() / (float)RAND_MAX;
+	float_sink = sum;
+	return reps;
+}
+
+uint64_t bench_sqrt_latency(uint64_t reps) {
+	/* Viete's formula: each root is of 2 plus the previous root. */
+	double x = 0.0;
+	for (uint64_t i = 0; i < reps; ++i) x = sqrt(2.0 + x);
+	float_sink = x;
+	return reps;
+}
+
+uint64_t bench_sqrt_throughput(uint64_t reps) {
+	double sums[BENCH_CHAINS] = { 0 }, values[BENCH_CHAINS];
+	for (int k = 0; k < BENCH_CHAINS; ++k) values[k] = 2.0 + k;
+	for (uint64_t i = 0; i < reps; ++i) {
+		for (int k = 0; k < BENCH_CHAINS; ++k) {
+			sums[k] += sqrt(values[k]);
+			values[k] += 1.0;
+		}
+	}
+	for (int k = 0; k < BENCH_CHAINS; ++k) float_sink = sums[k];
+	return reps * BENCH_CHAINS;
+}
+
+uint64_t bench_div_latency(uint64_t reps) {
+	/* Each quotient is divided into the next, so no division can start before the previous one ends. */
+	double x = 1.5;
+	for (uint64_t i = 0; i < reps; ++i) x = 3.0 / x;
+	float_sink = x;
+	return reps;
+}
+
+uint64_t bench_div_throughput(uint64_t reps) {
+	/* Wallis product terms: 4k^2 / (4k^2 - 1), independent of each other. */
+	double products[BENCH_CHAINS], squares[BENCH_CHAINS];
+	for (int k = 0; k < BENCH_CHAINS; ++k) {
+		products[k] = 1.0;
+		squares[k] = 4.0 * (k + 1) * (k + 1);
+	}
+	for (uint64_t i = 0; i < reps; ++i) {
+		for (int k = 0; k < BENCH_CHAINS; ++k) {
+			products[k] *= squares[k] / (squares[k] - 1.0);
+			squares[k] += 8.0;
+		}
+	}
+	for (int k = 0; k < BENCH_CHAINS; ++k) float_sink = products[k];
+	return reps * BENCH_CHAINS;
+}
+
+uint64_t bench_bn_add_n(uint64_t reps) {
+	bn_limb carry = 0;
+	for (uint64_t i = 0; i < reps; ++i) carry += bn_add_n(limbs_r, limbs_a, limbs_b, BENCH_LIMBS);
+	sink = carry + limbs_r[BENCH_LIMBS - 1];
+	return reps * BENCH_LIMBS;
+}
+
+uint64_t bench_bn_addmul_1(uint64_t reps) {
+	bn_limb carry = 0;
+	for (uint64_t i = 0; i < reps; ++i) carry += bn_addmul_1(limbs_r, limbs_a, BENCH_LIMBS, limbs_b[i % BENCH_LIMBS]);
+	sink = carry + limbs_r[BENCH_LIMBS - 1];
+	return reps * BENCH_LIMBS;
+}
+
+uint64_t bench_bn_mul_basecase(uint64_t reps) {
+	for (uint64_t i = 0; i < reps; ++i) bn_mul_basecase(limbs_r, limbs_a, BENCH_BASECASE_LIMBS, limbs_b, BENCH_BASECASE_LIMBS);
+	sink = limbs_r[BENCH_BASECASE_LIMBS];
+	return reps * BENCH_BASECASE_LIMBS * BENCH_BASECASE_LIMBS;
+}
+
+uint64_t bench_dn_add_n(uint64_t reps) {
+	dn_limb carry = 0;
+	for (uint64_t i = 0; i < reps; ++i) carry += dn_add_n(dec_r, dec_a, dec_a, BENCH_LIMBS);
+	sink = carry + dec_r[BENCH_LIMBS - 1];
+	return reps * BENCH_LIMBS;
+}
+
+uint64_t bench_dn_addmul_1(uint64_t reps) {
+	/* Start from zero each time, as the limbs stay below the base only while the carries are propagated. */
+	dn_limb carry = 0;
+	memset(dec_r, 0, sizeof dec_r);
+	for (uint64_t i = 0; i < reps; ++i) carry += dn_addmul_1(dec_r, dec_a, BENCH_LIMBS, dec_a[i % BENCH_LIMBS]);
+	sink = carry + dec_r[BENCH_LIMBS - 1];
+	return reps * BENCH_LIMBS;
+}
+
+/* Number of butterflies in one transform of BENCH_NTT_VALUES values. */
+static uint64_t ntt_butterflies(void) {
+	uint64_t stages = 0;
+	for (size_t len = BENCH_NTT_VALUES; len >= 2; len >>= 1) ++stages;
+	return stages * BENCH_NTT_VALUES / 2;
+}
+
+uint64_t bench_ntt_forward(uint64_t reps) {
+	for (uint64_t i = 0; i < reps; ++i) bn_ntt_forward(ntt_values, BENCH_NTT_VALUES, 0, ntt_twiddles);
+	sink = ntt_values[1];
+	return reps * ntt_butterflies();
+}
+
+uint64_t bench_ntt_inverse(uint64_t reps) {
+	for (uint64_t i = 0; i < reps; ++i) bn_ntt_inverse(ntt_values, BENCH_NTT_VALUES, 0, ntt_twiddles);
+	sink = ntt_values[1];
+	return reps * ntt_butterflies();
+}
+
+uint64_t bench_ntt_mulmod(uint64_t reps) {
+	/* The reduction of each butterfly's product, as a dependent chain. */
+	const uint64_t p = bn_ntt_primes[0], w = bn_ntt_roots[0];
+	uint64_t x = 12345;
+	for (uint64_t i = 0; i < reps; ++i) x = x * w % p;
+	sink = x;
+	return reps;
+}
+
+uint64_t bench_mulmod_prime(uint64_t reps) {
+	/* The 61-bit reduction of product verification, as a dependent chain. */
+	const uint64_t p = UINT64_C(2305843009213693951);
+	uint64_t x = UINT64_C(0x123456789ABCDEF);
+	for (uint64_t i = 0; i < reps; ++i) x = bn_mulmod_prime(x, UINT64_C(0x1F2E3D4C5B6A798), p);
+	sink = x;
+	return reps;
+}
+
+uint64_t bench_mod_prime(uint64_t reps) {
+	const uint64_t p = UINT64_C(2305843009213693951);
+	uint64_t sum = 0;
+	for (uint64_t i = 0; i < reps; ++i) {
+		limbs_a[0] = (bn_limb)i;
+		sum += bn_mod_prime(limbs_a, BENCH_LIMBS, p);
+	}
+	sink = sum;
+	return reps * BENCH_LIMBS;
+}
@@ -0,0 +1,240 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Calculates the decimal digits of pi starting at any position without calculating the digits
+   before it, which is useful for spot-checking digits of a previous (much larger) calculation.
+
+   This uses Fabrice Bellard's improvement of Simon Plouffe's algorithm, which is based on the series
+
+       pi + 3 = sum(k * 2^k / binomial(2k, k), k = 1..infinity)
+
+   The denominator of every term only contains odd primes below 2N (where N is the number of terms),
+   so the fractional part of 10^(n - 1) * pi is the sum of each prime's part of the series taken
+   modulo a power of that prime. Each of these only needs a few integers, so memory use is tiny,
+   while the time taken grows as about n^2. The primes are shared between the threads.
+
+   The number of terms is derived from a bound on the tail of the series, and each prime's part is kept
+   as a 64-bit fixed point fraction, whose sum modulo 1 is exact. Only the truncation of each part to 64
+   bits is lost: at most 2^-64 for each of fewer than 2^26 primes (below MAX_POSITION), which is below
+   2^-38 in total. Together with the tail, the sum is within 10^-11 of the true value, so the last of the
+   9 printed digits can only be wrong when it is followed by a long run of 0s or 9s.
+
+   See the following articles for more information:
+   https://bellard.org/pi/pi1.c
+   https://en.wikipedia.org/wiki/Spigot_algorithm
+*/
+
+/* Required includes. */
+#include "c_threads.h"
+#include "c_bench.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+
+/* Number of digits printed from the given position. */
+#define NTH_DIGITS_COUNT 9
+
+/* Digits after the printed ones that the tail of the series (beyond the calculated terms) must stay below. */
+#define TAIL_GUARD_DIGITS 2
+
+/* Largest supported position, so all moduli (below 2N) fit in 32 bits. */
+#define MAX_POSITION 100000000L
+
+/* Data for each thread's share of the primes. */
+typedef struct {
+	long position; /* Position of the first digit after the decimal point, starting at 1. */
+	uint64_t terms; /* Number of terms of the series (N). */
+	int index, count; /* This thread uses every 'count'th prime starting from the 'index'th. */
+	uint64_t sum; /* Fractional part of the sum of the used primes' parts, multiplied by 2^64. */
+} nth_thread_data;
+
+/* Calculates the sum of the given thread's share of the primes. */
+thread_func_t nth_digit_thread(thread_arg_t data);
+
+/* Returns the fractional part of 10^(position - 1) multiplied by the series using only the given prime, multiplied by 2^64. */
+uint64_t prime_part(uint64_t prime, long position, uint64_t terms);
+
+/* Returns the number of terms needed for the digits at the given position. */
+uint64_t terms_needed(long position);
+
+/* Returns non-zero if the given odd number is prime. */
+int is_odd_prime(uint64_t x);
+
+/* Returns (base^exponent) mod 'mod', where 'mod' is below 2^32. */
+uint64_t pow_mod(uint64_t base, uint64_t exponent, uint64_t mod);
+
+/* Returns the inverse of 'x' modulo 'mod', where they are coprime. */
+uint64_t inv_mod(uint64_t x, uint64_t mod);
+
+int main(int argc, char *argv[]) {
+	/* Validate arguments count. */
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "Usage: %s position [num_threads]\nPosition 1 is the first digit after the decimal point.\n", *argv);
+		return EXIT_FAILURE;
+	}
+
+	/* Get and validate the position and optional thread count. */
+	const long position = strtol(argv[1], NULL, 10);
+	const int num_threads = argc == 3 ? atoi(argv[2]) : 1;
+
+	if (position <= 0 || position > MAX_POSITION) {
+		fprintf(stderr, "Position must be between 1 and %ld.\n", MAX_POSITION);
+		return EXIT_FAILURE;
+	}
+
+	if (num_threads <= 0) {
+		fprintf(stderr, "Thread count must be larger than 0.\n");
+		return EXIT_FAILURE;
+	}
+
+	nth_thread_data *const threads_data = malloc((size_t)num_threads * sizeof *threads_data);
+	thread_id_t *const thread_ids = malloc((size_t)num_threads * sizeof *thread_ids);
+	if (!threads_data || !thread_ids) {
+		fprintf(stderr, "Could not allocate memory for %d threads.\n", num_threads);
+		free(threads_data);
+		free(thread_ids);
+		return EXIT_FAILURE;
+	}
+
+	/* Start timer and energy measurement. */
+	const clock_t start_time = clock();
+	pidef_energy energy;
+	pidef_energy_start(&energy);
+
+	const uint64_t terms = terms_needed(position);
+
+	for (int i = 0; i < num_threads; ++i) {
+		const nth_thread_data data = { position, terms, i, num_threads, 0 };
+		threads_data[i] = data;
+		pidef_create_thread(&thread_ids[i], nth_digit_thread, &threads_data[i]);
+	}
+
+	/* Combine the fractional parts of each thread, which wrap around modulo 1. */
+	uint64_t sum = 0;
+	for (int i = 0; i < num_threads; ++i) {
+		pidef_join_thread(thread_ids[i]);
+		sum += threads_data[i].sum;
+	}
+
+	/* The digits are floor(sum * 10^9 / 2^64), multiplied in 32-bit halves. */
+	const uint64_t digits = ((sum >> 32) * UINT64_C(1000000000) + ((sum & 0xFFFFFFFFu) * UINT64_C(1000000000) >> 32)) >> 32;
+
+	/* End timer. */
+	const clock_t end_time = clock();
+	pidef_energy_stop(&energy);
+
+	printf("Digits at position %ld: %0*" PRIu64 "\nTime taken: %fs\n", position, NTH_DIGITS_COUNT,
+		digits, (double)(end_time - start_time) / CLOCKS_PER_SEC);
+	pidef_energy_print(&energy, (double)NTH_DIGITS_COUNT, "digits");
+
+	free(threads_data);
+	free(thread_ids);
+	return EXIT_SUCCESS;
+}
+
+thread_func_t nth_digit_thread(thread_arg_t data) {
+	nth_thread_data *const given = (nth_thread_data*)data;
+	int prime_index = 0;
+
+	/* Only odd primes appear in the denominators. */
+	for (uint64_t prime = 3; prime <= 2 * given->terms; prime += 2) {
+		if (!is_odd_prime(prime)) continue;
+		if (prime_index++ % given->count != given->index) continue;
+		given->sum += prime_part(prime, given->position, given->terms);
+	}
+
+	return 0;
+}
+
+uint64_t terms_needed(long position) {
+	/*
+	   The terms are about sqrt(pi) * k^1.5 / 2^k and shrink by about half each, so the tail after N terms is below
+	   2 sqrt(pi) N^1.5 / 2^N. Shifted by 10^(position - 1), it must stay below 10^-(NTH_DIGITS_COUNT + TAIL_GUARD_DIGITS).
+	   Each term adds about log2(10) bits, which gives the first estimate, and the N^1.5 factor adds a few more terms.
+	*/
+	const double wanted = (double)(position - 1 + NTH_DIGITS_COUNT + TAIL_GUARD_DIGITS);
+	uint64_t terms = (uint64_t)(wanted * 3.321928094887362);
+	while ((double)terms * 0.30102999566398120 - log10(3.5449077018110318 * pow((double)terms, 1.5)) < wanted) ++terms;
+	return terms;
+}
+
+uint64_t prime_part(uint64_t prime, long position, uint64_t terms) {
+	/* The prime's exponent in any denominator is at most vmax, so all parts are taken modulo prime^vmax. */
+	int vmax = 0;
+	uint64_t mod = 1;
+	for (; mod * prime <= 2 * terms; ++vmax) mod *= prime;
+
+	/* Powers of the prime, used to scale terms with fewer factors of the prime to the same modulus. */
+	uint64_t powers[64];
+	powers[0] = 1;
+	for (int i = 1; i <= vmax; ++i) powers[i] = powers[i - 1] * prime;
+
+	/*
+	   Each term is k * k! / (2k - 1)!!. 'num' and 'den' are the products of k! and (2k - 1)!!
+	   without any factors of the prime, and 'v' is the prime's exponent in the denominator.
+	   The sum is kept as a fraction over 'den', so only a single modular inverse is needed at the end.
+	*/
+	uint64_t num = 1, den = 1, sum = 0;
+	int v = 0;
+
+	for (uint64_t k = 1; k <= terms; ++k) {
+		uint64_t t = k;
+		for (; t % prime == 0; t /= prime) --v;
+		num = num * t % mod;
+
+		t = 2 * k - 1;
+		for (; t % prime == 0; t /= prime) ++v;
+		den = den * t % mod;
+		sum = sum * t % mod;
+
+		/* Terms without the prime in their denominator are integers here and do not affect the fractional part. */
+		if (v > 0) {
+			t = num * (k % mod) % mod;
+			sum = (sum + t * powers[vmax - v]) % mod;
+		}
+	}
+
+	sum = sum * inv_mod(den, mod) % mod;
+
+	/* Shift the wanted digits to just after the decimal point. */
+	sum = sum * pow_mod(10, (uint64_t)position - 1, mod) % mod;
+
+	/* floor(sum * 2^64 / mod) in two 32-bit steps, as 'sum' is below 'mod' which is below 2^32. */
+	const uint64_t high = (sum << 32) / mod, low = ((sum << 32) % mod << 32) / mod;
+	return high << 32 | low;
+}
+
+int is_odd_prime(uint64_t x) {
+	for (uint64_t d = 3; d * d <= x; d += 2) if (x % d == 0) return 0;
+	return 1;
+}
+
+uint64_t pow_mod(uint64_t base, uint64_t exponent, uint64_t mod) {
+	uint64_t result = 1 % mod;
+	base %= mod;
+
+	for (; exponent; exponent >>= 1) {
+		if (exponent & 1) result = result * base % mod;
+		base = base * base % mod;
+	}
+
+	return result;
+}
+
+uint64_t inv_mod(uint64_t x, uint64_t mod) {
+	/* Extended Euclidean algorithm. */
+	int64_t old_r = (int64_t)mod, r = (int64_t)x, old_s = 0, s = 1;
+
+	while (r) {
+		const int64_t q = old_r / r, next_r = old_r - q * r, next_s = old_s - q * s;
+		old_r = r;
+		r = next_r;
+		old_s = s;
+		s = next_s;
+	}
+
+	return (uint64_t)(old_s < 0 ? old_s + (int64_t)mod : old_s);
+}
@@ -0,0 +1,157 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Spigot algorithm for pi, which produces the digits one group at a time from left to right
+   instead of all at once at the end, so consumers (such as a pipe) can read the first digits immediately.
+
+   This is the Rabinowitz-Wagon spigot in the form popularised by Dik Winter, which extracts 4 digits
+   per step (base 10000) from a mixed-radix representation of pi and drops 14 terms each step, as each
+   term only carries about log10(2) digits of information. The mixed-radix digits fit in 32 bits,
+   so memory use is fixed at about 14 bytes per requested digit and no arbitrary precision
+   arithmetic is needed, at the cost of quadratic time.
+
+   A group can occasionally be 10000 or more, carrying into the groups before it. Groups of 9999
+   are therefore held back until a smaller group shows they cannot change.
+
+   See the following articles for more information:
+   https://en.wikipedia.org/wiki/Spigot_algorithm
+   https://www.cs.williams.edu/~heeringa/classes/cs135/s15/readings/spigot.pdf
+*/
+
+/* Required includes. */
+#include "c_bench.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+/* Digits produced by each step, and their base. */
+#define SPIGOT_GROUP_DIGITS 4
+#define SPIGOT_BASE 10000U
+
+/* Terms of the mixed-radix representation consumed by each step. */
+#define SPIGOT_GROUP_TERMS 14
+
+/* Extra groups calculated so carries into the last printed digits are resolved. */
+#define GUARD_GROUPS 2
+
+/* Output state, holding back groups that may still receive a carry. */
+typedef struct {
+	long remaining; /* Digits still to be printed. */
+	uint32_t held; /* Last group before any held 9999 groups. */
+	long nines; /* Number of held 9999 groups. */
+	int has_held; /* Non-zero if 'held' contains a group. */
+} spigot_output;
+
+/* Prints the given group of digits, stopping once all requested digits are printed. */
+void print_group(spigot_output *out, uint32_t group);
+
+/* Adds a newly extracted group, which may be 10000 or more, and prints any groups that can no longer change. */
+void push_group(spigot_output *out, uint32_t group);
+
+/* Prints any held groups once there are no more to extract. */
+void flush_groups(spigot_output *out);
+
+int main(int argc, char *argv[]) {
+	/* Validate arguments count. */
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s pi_digits\n", *argv);
+		return EXIT_FAILURE;
+	}
+
+	/* Get and validate pi digits accuracy. */
+	const long digits = strtol(argv[1], NULL, 10);
+	if (digits <= 0) {
+		fprintf(stderr, "Digits count must be larger than 0.\n");
+		return EXIT_FAILURE;
+	}
+
+	/* Include the leading '3' as with the other pi programs, and limit the size so the mixed-radix digits fit in 32 bits. */
+	const long groups = (digits + 1 + SPIGOT_GROUP_DIGITS - 1) / SPIGOT_GROUP_DIGITS + GUARD_GROUPS;
+	if (groups > 100000000L / SPIGOT_GROUP_TERMS) {
+		fprintf(stderr, "Digits count is too large for the spigot algorithm.\n");
+		return EXIT_FAILURE;
+	}
+
+	/* Mixed-radix digits of pi, all starting at 2 (multiplied by the base as the first step is base 10000). */
+	size_t terms = (size_t)groups * SPIGOT_GROUP_TERMS;
+	uint32_t *const mixed = malloc((terms + 1) * sizeof *mixed);
+	if (!mixed) {
+		fprintf(stderr, "Could not allocate memory for %zu terms.\n", terms);
+		return EXIT_FAILURE;
+	}
+	for (size_t i = 0; i < terms; ++i) mixed[i] = SPIGOT_BASE / 5U;
+	mixed[terms] = 0;
+
+	/* Start timer and energy measurement. */
+	const clock_t start_time = clock();
+	pidef_energy energy;
+	pidef_energy_start(&energy);
+
+	printf("Pi approximation: ");
+	spigot_output out = { digits + 1, 0, 0, 0 };
+	uint32_t remainder = 0;
+
+	for (; terms; terms -= SPIGOT_GROUP_TERMS) {
+		/*
+		   Multiply the mixed-radix number by the base and normalise it from the right. Term i has
+		   radix i / (2i - 1), so each term carries (value / (2i - 1)) * (i - 1) into the next.
+		*/
+		uint64_t carry = 0;
+		uint64_t denominator = 2 * (uint64_t)terms;
+		for (size_t i = terms;; carry *= i) {
+			carry += (uint64_t)mixed[i] * SPIGOT_BASE;
+			mixed[i] = (uint32_t)(carry % --denominator);
+			carry /= denominator--;
+			if (!--i) break;
+		}
+
+		/* The integer part is the next group of digits, combined with the previous step's remainder. */
+		push_group(&out, remainder + (uint32_t)(carry / SPIGOT_BASE));
+		remainder = (uint32_t)(carry % SPIGOT_BASE);
+		fflush(stdout);
+	}
+
+	flush_groups(&out);
+
+	/* End timer. */
+	const clock_t end_time = clock();
+	pidef_energy_stop(&energy);
+	printf("\nTime taken: %fs\n", (double)(end_time - start_time) / CLOCKS_PER_SEC);
+	pidef_energy_print(&energy, (double)digits, "digits");
+
+	free(mixed);
+	return EXIT_SUCCESS;
+}
+
+void print_group(spigot_output *out, uint32_t group) {
+	char group_str[SPIGOT_GROUP_DIGITS + 1];
+	snprintf(group_str, sizeof group_str, "%0*" PRIu32, SPIGOT_GROUP_DIGITS, group);
+
+	for (int i = 0; i < SPIGOT_GROUP_DIGITS && out->remaining > 0; ++i, --out->remaining) putchar(group_str[i]);
+}
+
+void push_group(spigot_output *out, uint32_t group) {
+	if (group >= SPIGOT_BASE) {
+		/* Carry into the held group, turning any held 9999 groups into 0000. */
+		print_group(out, out->held + 1U);
+		for (; out->nines; --out->nines) print_group(out, 0);
+		out->held = group - SPIGOT_BASE;
+	} else if (group == SPIGOT_BASE - 1U && out->has_held) {
+		++out->nines;
+		return;
+	} else {
+		if (out->has_held) print_group(out, out->held);
+		for (; out->nines; --out->nines) print_group(out, SPIGOT_BASE - 1U);
+		out->held = group;
+	}
+
+	out->has_held = 1;
+}
+
+void flush_groups(spigot_output *out) {
+	if (out->has_held) print_group(out, out->held);
+	for (; out->nines; --out->nines) print_group(out, SPIGOT_BASE - 1U);
+	out->has_held = 0;
+}
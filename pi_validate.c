@@ -0,0 +1,335 @@
+/*
+   Copyright 2025 Mahdi Almusaad (https://github.com/mahdialmusaad)
+   under the MIT License (https://opensource.org/license/mit)
+
+   Validates a file of calculated digits (such as the output of pi_chudnovsky --output) against a
+   reference file of known digits, reporting the first position where they differ.
+
+   Both files are memory mapped instead of read, and the common part is split into one chunk per thread.
+   Each chunk is compared 128 bytes at a time with AVX2 on processors that support it (checked when
+   the program starts), otherwise with memcmp, so the comparison runs at about the speed of memory.
+   Trailing whitespace (such as the newline after the digits) is ignored, as is a '.' after the leading 3 in
+   either file, so "3.14..." and "314..." compare equal and positions count digits. The output only needs to
+   match the start of the reference, as reference files usually have more digits than a calculation, and
+   how much of the reference it covered is reported.
+*/
+
+/* Required includes. */
+#include "c_threads.h"
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h> /* Only included by c_threads.h with MSVC, not MinGW. */
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* AVX2 is only used with compilers that can enable it for a single function. */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define VALIDATE_HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+/* Number of bytes compared with memcmp before checking for a difference, when AVX2 is not available. */
+#define VALIDATE_BLOCK_BYTES 4096
+
+/* Number of bytes either side of a mismatch that are printed. */
+#define VALIDATE_CONTEXT 16
+
+/* A read-only memory mapped file. */
+typedef struct {
+	const unsigned char *data; /* NULL for an empty file. */
+	size_t size;
+	#ifdef _WIN32
+	HANDLE file, mapping;
+	#endif
+} mapped_file;
+
+/* The digits of a mapped file, skipping a '.' after the leading 3. */
+typedef struct {
+	const unsigned char *data;
+	size_t size; /* Number of digits, without the '.' and trailing whitespace. */
+	size_t skip; /* 1 if the second byte is a skipped '.', so digit 'i' (from 1) is at data[i + skip]. */
+} digit_view;
+
+/* Data for each thread's chunk of the files. */
+typedef struct {
+	const unsigned char *a, *b;
+	size_t start, end; /* Byte range compared by the thread. */
+	size_t mismatch; /* Position of the first difference in the range, or 'end' if there is none. */
+} validate_thread_data;
+
+/* Returns the position of the first differing byte of 'a' and 'b', or 'n' if they are equal. */
+typedef size_t (*mismatch_func)(const unsigned char *a, const unsigned char *b, size_t n);
+
+/* Comparison function chosen for the processor. */
+static mismatch_func first_mismatch;
+
+/* Maps the given file into memory. Returns non-zero on success. */
+int map_file(mapped_file *file, const char *path);
+
+/* Unmaps a file mapped with map_file. */
+void unmap_file(mapped_file *file);
+
+/* Returns the given size without any trailing whitespace of the data. */
+size_t trimmed_size(const unsigned char *data, size_t size);
+
+/* Returns the digits of the given file, without trailing whitespace or a '.' after the leading 3. */
+digit_view file_digits(const mapped_file *file);
+
+/* Returns the digit at the given position of the view. */
+unsigned char digit_at(const digit_view *view, size_t pos);
+
+/* Portable comparison with memcmp, finding the byte within the first differing block. */
+size_t first_mismatch_memcmp(const unsigned char *a, const unsigned char *b, size_t n);
+
+#ifdef VALIDATE_HAVE_AVX2
+/* Comparison with 256-bit vectors. Only called when the processor supports AVX2. */
+size_t first_mismatch_avx2(const unsigned char *a, const unsigned char *b, size_t n);
+#endif
+
+/* Compares the given thread's chunk. */
+thread_func_t validate_thread(thread_arg_t data);
+
+/* Prints the digits around the given position with the given label. */
+void print_context(const char *label, const digit_view *view, size_t pos);
+
+int main(int argc, char *argv[]) {
+	/* Validate arguments count. */
+	if (argc < 3 || argc > 4) {
+		fprintf(stderr, "Usage: %s digits_file reference_file [num_threads]\n", *argv);
+		return EXIT_FAILURE;
+	}
+
+	/* Get and validate the optional thread count. */
+	const int num_threads = argc == 4 ? atoi(argv[3]) : 1;
+	if (num_threads <= 0) {
+		fprintf(stderr, "Thread count must be larger than 0.\n");
+		return EXIT_FAILURE;
+	}
+
+	mapped_file digits, reference;
+	if (!map_file(&digits, argv[1])) {
+		fprintf(stderr, "Could not open digits file \"%s\".\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	if (!map_file(&reference, argv[2])) {
+		fprintf(stderr, "Could not open reference file \"%s\".\n", argv[2]);
+		unmap_file(&digits);
+		return EXIT_FAILURE;
+	}
+
+	validate_thread_data *const threads_data = malloc((size_t)num_threads * sizeof *threads_data);
+	thread_id_t *const thread_ids = malloc((size_t)num_threads * sizeof *thread_ids);
+	if (!threads_data || !thread_ids) {
+		fprintf(stderr, "Could not allocate memory for %d threads.\n", num_threads);
+		return EXIT_FAILURE;
+	}
+
+	/* Choose the comparison for this processor. */
+	const char *method = "memcmp";
+	first_mismatch = first_mismatch_memcmp;
+	#ifdef VALIDATE_HAVE_AVX2
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		method = "AVX2";
+		first_mismatch = first_mismatch_avx2;
+	}
+	#endif
+
+	/* Start timer. */
+	const double start_time = pidef_wall_seconds();
+
+	const digit_view digits_view = file_digits(&digits), reference_view = file_digits(&reference);
+	const size_t digits_size = digits_view.size, reference_size = reference_view.size;
+	const size_t common = digits_size < reference_size ? digits_size : reference_size;
+
+	/* An empty digits file would trivially match any reference. */
+	if (!digits_size) {
+		fprintf(stderr, "Digits file \"%s\" has no digits.\n", argv[1]);
+		free(threads_data);
+		free(thread_ids);
+		unmap_file(&digits);
+		unmap_file(&reference);
+		return EXIT_FAILURE;
+	}
+
+	/*
+	   Split the common part after the leading digit into one chunk per thread. The threads compare from
+	   past each file's skipped '.', so their positions are the same for both files.
+	*/
+	const size_t chunk = common ? (common - 1) / (size_t)num_threads + 1 : 0;
+	for (int i = 0; i < num_threads; ++i) {
+		const size_t start = 1 + chunk * (size_t)i < common ? 1 + chunk * (size_t)i : common;
+		const size_t end = start + chunk < common ? start + chunk : common;
+		const validate_thread_data data = { digits.data + digits_view.skip, reference.data + reference_view.skip, start, end, end };
+		threads_data[i] = data;
+		pidef_create_thread(&thread_ids[i], validate_thread, &threads_data[i]);
+	}
+
+	/* The first mismatch is either the leading digit or in the first chunk that has one. */
+	size_t mismatch = common && digits.data[0] != reference.data[0] ? 0 : common;
+	for (int i = 0; i < num_threads; ++i) {
+		pidef_join_thread(thread_ids[i]);
+		if (mismatch == common && threads_data[i].mismatch < threads_data[i].end) mismatch = threads_data[i].mismatch;
+	}
+
+	/* End timer. */
+	const double seconds = pidef_wall_seconds() - start_time;
+
+	int valid = mismatch == common && digits_size <= reference_size;
+	printf("Compared %zu digits with %s using %d thread(s) (%.2f GB/s)\n", common, method, num_threads,
+		seconds > 0.0 ? 2.0 * (double)common / seconds * 1e-9 : 0.0);
+
+	if (mismatch < common) {
+		printf("First mismatch at digit %zu: '%c' instead of '%c'\n", mismatch,
+			digit_at(&digits_view, mismatch), digit_at(&reference_view, mismatch));
+		print_context("Digits:   ", &digits_view, mismatch);
+		print_context("Reference:", &reference_view, mismatch);
+	} else if (digits_size > reference_size) {
+		printf("All %zu digits of the reference match, but the digits file has %zu more that could not be checked\n",
+			reference_size, digits_size - reference_size);
+	} else {
+		printf("All %zu digits match the reference, covering %.2f%% of its %zu digits\n", digits_size,
+			100.0 * (double)digits_size / (double)reference_size, reference_size);
+	}
+	printf("Time taken: %fs\n", seconds);
+
+	free(threads_data);
+	free(thread_ids);
+	unmap_file(&digits);
+	unmap_file(&reference);
+	return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int map_file(mapped_file *file, const char *path) {
+	file->data = NULL;
+	file->size = 0;
+
+	#ifdef _WIN32
+	file->mapping = NULL;
+	file->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file->file == INVALID_HANDLE_VALUE) return 0;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file->file, &size)) return 0;
+	file->size = (size_t)size.QuadPart;
+	if (!file->size) return 1;
+
+	file->mapping = CreateFileMappingA(file->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!file->mapping) return 0;
+	file->data = (const unsigned char*)MapViewOfFile(file->mapping, FILE_MAP_READ, 0, 0, 0);
+	return file->data != NULL;
+	#else
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0) return 0;
+
+	struct stat info;
+	if (fstat(fd, &info) || info.st_size < 0) {
+		close(fd);
+		return 0;
+	}
+
+	/* Empty files cannot be mapped, and do not need to be. The mapping stays valid once the file is closed. */
+	file->size = (size_t)info.st_size;
+	if (file->size) {
+		void *const data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED) {
+			#ifdef MADV_SEQUENTIAL
+			madvise(data, file->size, MADV_SEQUENTIAL);
+			#endif
+			file->data = (const unsigned char*)data;
+		}
+	}
+
+	close(fd);
+	return !file->size || file->data;
+	#endif
+}
+
+void unmap_file(mapped_file *file) {
+	#ifdef _WIN32
+	if (file->data) UnmapViewOfFile(file->data);
+	if (file->mapping) CloseHandle(file->mapping);
+	if (file->file != INVALID_HANDLE_VALUE) CloseHandle(file->file);
+	#else
+	if (file->data) munmap((void*)file->data, file->size);
+	#endif
+	file->data = NULL;
+	file->size = 0;
+}
+
+size_t trimmed_size(const unsigned char *data, size_t size) {
+	while (size && (data[size - 1] == '\n' || data[size - 1] == '\r' || data[size - 1] == ' ' || data[size - 1] == '\t')) --size;
+	return size;
+}
+
+digit_view file_digits(const mapped_file *file) {
+	digit_view view = { file->data, trimmed_size(file->data, file->size), 0 };
+	if (view.size >= 2 && view.data[0] == '3' && view.data[1] == '.') {
+		view.skip = 1;
+		--view.size;
+	}
+	return view;
+}
+
+unsigned char digit_at(const digit_view *view, size_t pos) {
+	return view->data[pos ? pos + view->skip : 0];
+}
+
+size_t first_mismatch_memcmp(const unsigned char *a, const unsigned char *b, size_t n) {
+	size_t i = 0;
+	for (; i + VALIDATE_BLOCK_BYTES <= n && !memcmp(a + i, b + i, VALIDATE_BLOCK_BYTES); i += VALIDATE_BLOCK_BYTES);
+	for (; i < n; ++i) if (a[i] != b[i]) return i;
+	return n;
+}
+
+#ifdef VALIDATE_HAVE_AVX2
+__attribute__((target("avx2")))
+size_t first_mismatch_avx2(const unsigned char *a, const unsigned char *b, size_t n) {
+	#define VALIDATE_EQ(offset) _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(a + (offset))), \
+		_mm256_loadu_si256((const __m256i*)(b + (offset))))
+
+	/* Four vectors per iteration, combined so only one mask is checked until there is a difference. */
+	size_t i = 0;
+	for (; i + 128 <= n; i += 128) {
+		const __m256i equal = _mm256_and_si256(_mm256_and_si256(VALIDATE_EQ(i), VALIDATE_EQ(i + 32)),
+			_mm256_and_si256(VALIDATE_EQ(i + 64), VALIDATE_EQ(i + 96)));
+		if ((uint32_t)_mm256_movemask_epi8(equal) != 0xFFFFFFFFu) break;
+	}
+
+	/* Find the differing byte from the lowest unset bit of the equality mask. */
+	for (; i + 32 <= n; i += 32) {
+		const uint32_t mask = (uint32_t)_mm256_movemask_epi8(VALIDATE_EQ(i));
+		if (mask != 0xFFFFFFFFu) return i + (size_t)__builtin_ctz(~mask);
+	}
+	#undef VALIDATE_EQ
+
+	for (; i < n; ++i) if (a[i] != b[i]) return i;
+	return n;
+}
+#endif
+
+thread_func_t validate_thread(thread_arg_t data) {
+	validate_thread_data *const given = (validate_thread_data*)data;
+	given->mismatch = given->start + first_mismatch(given->a + given->start, given->b + given->start, given->end - given->start);
+	return 0;
+}
+
+void print_context(const char *label, const digit_view *view, size_t pos) {
+	const size_t start = pos > VALIDATE_CONTEXT ? pos - VALIDATE_CONTEXT : 0;
+	const size_t end = view->size - pos > VALIDATE_CONTEXT ? pos + VALIDATE_CONTEXT + 1 : view->size;
+
+	printf("  %s %s", label, start ? "..." : "");
+	for (size_t i = start; i < end; ++i) {
+		if (i == pos) printf("[%c]", digit_at(view, i));
+		else putchar(digit_at(view, i));
+	}
+	printf("%s\n", end < view->size ? "..." : "");
+}